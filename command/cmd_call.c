@@ -0,0 +1,75 @@
+/**
+ * @file cmd_call.c
+ * @author Liber (lvlebin@outlook.com)
+ * @brief nano-shell build in command: call
+ * @version 1.0
+ * @date 2020-04-02
+ *
+ * @copyright Copyright (c) Liber 2020
+ *
+ */
+
+
+#include "command.h"
+#include "shell_io/shell_io.h"
+
+#include "shell_config.h"
+
+/****************************** build in command: call ******************************/
+#if CONFIG_SHELL_FUNC_CALL
+
+static void shell_print_func_list(void)
+{
+  const shell_func_t *tmp = _shell_entry_start(shell_func_t);
+  unsigned int count = _shell_entry_count(shell_func_t);
+
+  while (count) {
+#if CONFIG_SHELL_FUNC_BRIEF_USAGE
+    shell_printf("  %s(%d): %s\r\n", tmp->name, tmp->param_n, tmp->brief);
+#else
+    shell_printf("  %s(%d)\r\n", tmp->name, tmp->param_n);
+#endif
+    count--;
+    tmp++;
+  }
+}
+
+
+int shell_cmd_call(const shell_cmd_t *pcmd, int argc, char *const argv[])
+{
+  const shell_func_t *pFunc;
+  int result;
+
+  if (argc == 1) {
+    shell_print_func_list();
+    return 0;
+  }
+
+  pFunc = shell_find_func(argv[1]);
+  if (pFunc == NULL) {
+    shell_printf("  %s: function not found.\r\n", argv[1]);
+    return -1;
+  }
+
+  if (shell_call_func(pFunc, argc - 1, argv + 1, &result) != 0) {
+    return -1;
+  }
+
+  shell_printf("  %s() = %d (0x%x)\r\n", pFunc->name, result, (unsigned int)result);
+  return 0;
+}
+
+NANO_SHELL_ADD_CMD(call,
+                   shell_cmd_call,
+                   "call [function [args ...]]",
+
+                   "    Call a function added by NANO_SHELL_ADD_FUNC(), and print the result.\r\n"
+                   "\r\n"
+                   "    If FUNCTION is not specified, print the list of all available functions.\r\n"
+                   "\r\n"
+                   "    Arguments:\r\n"
+                   "        FUNCTION: name of the function\r\n"
+                   "        ARGS: decimal or hexadecimal(0x) numbers, single characters,\r\n"
+                   "              or strings (passed as pointers)\r\n");
+
+#endif /* CONFIG_SHELL_FUNC_CALL */
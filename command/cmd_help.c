@@ -47,6 +47,13 @@ static void shell_print_cmd_help(const char *cmd_name,
 
     // use puts() instead of printf() to avoid printf buffer overflow
     shell_puts(tmp->help);
+
+#if CONFIG_SHELL_CMD_ARG_SPEC
+    if (tmp->args) {
+      shell_puts("\r\n");
+      shell_print_args_help(tmp->name, tmp->args);
+    }
+#endif /* CONFIG_SHELL_CMD_ARG_SPEC */
   } else {
     shell_printf("%s: command not found.\r\n", cmd_name);
   }
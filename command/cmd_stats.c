@@ -0,0 +1,183 @@
+/**
+ * @file cmd_stats.c
+ * @author Liber (lvlebin@outlook.com)
+ * @brief execution statistics of the commands, nano-shell build in command: time, cmdstats
+ * @version 1.0
+ * @date 2020-04-08
+ *
+ * @copyright Copyright (c) Liber 2020
+ *
+ */
+
+#include <string.h>
+
+#include "command.h"
+#include "shell_io/shell_io.h"
+
+#include "shell_config.h"
+
+#if CONFIG_SHELL_CMD_STATS > 0
+
+#if CONFIG_SHELL_CMD_STATS > 256
+#error "CONFIG_SHELL_CMD_STATS must be no more than 256."
+#endif
+
+/**
+ * `shell_cmd_stats_table[i]` is the statistics of the i-th entry of the command table, the commands
+ * after the first CONFIG_SHELL_CMD_STATS entries are not counted.
+ * shared by all the consoles if CONFIG_SHELL_MULTI_INSTANCE is enabled.
+ */
+static shell_cmd_stats_t shell_cmd_stats_table[CONFIG_SHELL_CMD_STATS];
+
+int shell_cmd_time(const shell_cmd_t *pcmd, int argc, char *const argv[]);
+
+
+shell_cmd_stats_t *shell_cmd_stats(const shell_cmd_t *pCmdt)
+{
+  unsigned int index = (unsigned int)(pCmdt - _shell_entry_start(shell_cmd_t));
+
+  if (index < CONFIG_SHELL_CMD_STATS && index < _shell_entry_count(shell_cmd_t)) {
+    return &shell_cmd_stats_table[index];
+  }
+  return NULL;
+}
+
+
+void shell_cmd_stats_begin(shell_cmd_probe_t *probe)
+{
+  probe->bytes = shell_output_count();
+  probe->cycles = shell_cycle_counter();
+}
+
+
+unsigned long shell_cmd_stats_end(const shell_cmd_t *pCmdt, const shell_cmd_probe_t *probe)
+{
+  unsigned long cycles = shell_cycle_counter() - probe->cycles;
+  shell_cmd_stats_t *stats = shell_cmd_stats(pCmdt);
+
+  if (stats) {
+    if (stats->calls == 0 || cycles < stats->min) {
+      stats->min = cycles;
+    }
+    if (cycles > stats->max) {
+      stats->max = cycles;
+    }
+    stats->total += cycles;
+    stats->bytes += shell_output_count() - probe->bytes;
+    stats->calls++;
+  }
+
+  return cycles;
+}
+
+
+int shell_cmd_run_measured(const shell_cmd_t *pCmdt, shell_cmd_cb_t fct, int argc, char *const argv[])
+{
+  shell_cmd_probe_t probe;
+  int ret;
+
+  // `time` measures the command it runs, don't count the same cycles twice.
+  if (pCmdt->cmd == shell_cmd_time) {
+    return fct(pCmdt, argc, argv);
+  }
+
+  shell_cmd_stats_begin(&probe);
+  ret = fct(pCmdt, argc, argv);
+  shell_cmd_stats_end(pCmdt, &probe);
+  return ret;
+}
+
+
+/****************************** build in command: time ******************************/
+
+int shell_cmd_time(const shell_cmd_t *pcmd, int argc, char *const argv[])
+{
+  shell_cmd_probe_t probe;
+  unsigned long cycles, bytes;
+  int ret;
+
+  (void)pcmd;
+
+  if (argc < 2) {
+    shell_puts("  usage: time command [args ...]\r\n");
+    return -1;
+  }
+
+  shell_cmd_stats_begin(&probe);
+  ret = shell_run_cmd(argc - 1, argv + 1);
+  cycles = shell_cycle_counter() - probe.cycles;
+  bytes = shell_output_count() - probe.bytes;
+
+  shell_printf("\r\n  %s: %lu cycles, %lu bytes of output, returned %d.\r\n", argv[1], cycles, bytes, ret);
+  return ret;
+}
+
+NANO_SHELL_ADD_CMD(time,
+                   shell_cmd_time,
+                   "time command [args ...]",
+
+                   "    Run a command, and print the cycles it took and the size of its output.\r\n"
+                   "\r\n"
+                   "    The cycles are counted by shell_cycle_counter().\r\n");
+
+
+/****************************** build in command: cmdstats ******************************/
+
+static void shell_print_cmd_stats(const shell_cmd_t *pCmdt, const shell_cmd_stats_t *stats)
+{
+  shell_printf("  %-12s %8lu %12llu %10llu %10lu %10lu %10lu\r\n", pCmdt->name, stats->calls,
+               stats->total, stats->total / stats->calls, stats->min, stats->max, stats->bytes);
+}
+
+
+int shell_cmd_cmdstats(const shell_cmd_t *pcmd, int argc, char *const argv[])
+{
+  const shell_cmd_t *start = _shell_entry_start(shell_cmd_t);
+  unsigned int count = _shell_entry_count(shell_cmd_t);
+  unsigned char order[CONFIG_SHELL_CMD_STATS];
+  unsigned int i, j, n = 0;
+
+  (void)pcmd;
+
+  if (argc > 1 && strcmp(argv[1], "-r") == 0) {
+    memset(shell_cmd_stats_table, 0, sizeof(shell_cmd_stats_table));
+    return 0;
+  }
+
+  if (count > CONFIG_SHELL_CMD_STATS) {
+    count = CONFIG_SHELL_CMD_STATS;
+  }
+
+  // sort the commands which have run by the total cycles, the most expensive first.
+  for (i = 0; i < count; i++) {
+    if (shell_cmd_stats_table[i].calls == 0) {
+      continue;
+    }
+    for (j = n; j > 0 && shell_cmd_stats_table[order[j - 1]].total < shell_cmd_stats_table[i].total; j--) {
+      order[j] = order[j - 1];
+    }
+    order[j] = (unsigned char)i;
+    n++;
+  }
+
+  shell_printf("  %-12s %8s %12s %10s %10s %10s %10s\r\n",
+               "command", "calls", "total", "avg", "min", "max", "bytes");
+  for (i = 0; i < n; i++) {
+    shell_print_cmd_stats(&start[order[i]], &shell_cmd_stats_table[order[i]]);
+  }
+
+  return 0;
+}
+
+NANO_SHELL_ADD_CMD(cmdstats,
+                   shell_cmd_cmdstats,
+                   "cmdstats [-r]",
+
+                   "    Print the execution statistics of the commands, the most expensive first:\r\n"
+                   "    the number of calls, the cycles (total, average, min and max) and the size\r\n"
+                   "    of the output.\r\n"
+                   "\r\n"
+                   "    Options:\r\n"
+                   "        -r: reset the statistics\r\n");
+
+#endif /* CONFIG_SHELL_CMD_STATS > 0 */
@@ -0,0 +1,266 @@
+/**
+ * @file cmd_watch.c
+ * @author Liber (lvlebin@outlook.com)
+ * @brief nano-shell build in command: watch
+ * @version 1.0
+ * @date 2020-04-06
+ *
+ * @copyright Copyright (c) Liber 2020
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "command.h"
+#include "shell_io/shell_io.h"
+#include "readline/key_seq.h"
+
+#include "shell_config.h"
+
+/****************************** build in command: watch ******************************/
+#if CONFIG_SHELL_CMD_WATCH
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+#include "nano_shell_ctx.h"
+
+// every shell context has its own jobs, the output goes to its console.
+  #define shell_watch_jobs (nano_shell_ctx->watch_jobs)
+#else
+static shell_watch_job_t shell_watch_jobs[CONFIG_SHELL_WATCH_JOBS];
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+#define SHELL_WATCH_DEFAULT_PERIOD (1000U)
+
+
+static void shell_watch_print_args(const shell_watch_job_t *job)
+{
+  int i;
+
+  for (i = 0; i < job->argc; i++) {
+    shell_printf(i ? " %s" : "%s", job->argv[i]);
+  }
+}
+
+
+/**
+ * the screen is cleared when any job is due, so every active job is redrawn then (the jobs which
+ * are not due yet run once more, their schedule is not changed).
+ */
+void shell_watch_run(void)
+{
+  shell_watch_job_t *job;
+  unsigned long now;
+  unsigned int i;
+
+  if (shell_watch_next() != 0) {
+    return;
+  }
+  now = shell_tick_ms();  // the jobs found due are still due.
+
+#if CONFIG_SHELL_ANSI_CURSOR
+  shell_puts("\033[H\033[2J");  // cursor home, clear the screen.
+#else
+  shell_puts("\r\n");
+#endif /* CONFIG_SHELL_ANSI_CURSOR */
+
+  for (i = 0; i < CONFIG_SHELL_WATCH_JOBS; i++) {
+    job = &shell_watch_jobs[i];
+    if (job->cmd == NULL) {
+      continue;
+    }
+
+    shell_printf("Every %ums: ", job->period);
+    shell_watch_print_args(job);
+    shell_puts("\r\n\r\n");
+    (void)shell_cmd_run_measured(job->cmd, job->cmd->cmd, job->argc, job->argv);
+    shell_puts("\r\n");
+
+    if ((long)(now - job->next) >= 0) {
+      job->next += job->period;
+      if ((long)(now - job->next) >= 0) {  // the command took too long, don't try to catch up.
+        job->next = now + job->period;
+      }
+    }
+  }
+
+  rl_redisplay();  // the input line goes below the output.
+}
+
+
+unsigned int shell_watch_next(void)
+{
+  unsigned long now = shell_tick_ms();
+  unsigned int i, next = ~0U;
+  long left;
+
+  for (i = 0; i < CONFIG_SHELL_WATCH_JOBS; i++) {
+    if (shell_watch_jobs[i].cmd) {
+      left = (long)(shell_watch_jobs[i].next - now);
+      if (left <= 0) {
+        return 0;
+      }
+      if ((unsigned long)left < next) {
+        next = (unsigned int)left;
+      }
+    }
+  }
+
+  return next;
+}
+
+
+static unsigned int shell_watch_kill(unsigned int first, unsigned int last)
+{
+  unsigned int n = 0;
+
+  for (; first <= last; first++) {
+    if (shell_watch_jobs[first].cmd) {
+      shell_watch_jobs[first].cmd = NULL;
+      n++;
+    }
+  }
+
+  return n;
+}
+
+
+unsigned int shell_watch_cancel(void)
+{
+  unsigned int n = shell_watch_kill(0, CONFIG_SHELL_WATCH_JOBS - 1);
+
+  if (n) {
+    shell_printf("\r\n  watch: %u job(s) cancelled.\r\n", n);
+    rl_redisplay();
+  }
+
+  return n;
+}
+
+
+static void shell_watch_list(void)
+{
+  const shell_watch_job_t *job;
+  unsigned int i;
+
+  for (i = 0; i < CONFIG_SHELL_WATCH_JOBS; i++) {
+    job = &shell_watch_jobs[i];
+    if (job->cmd) {
+      shell_printf("  %u: every %ums: ", i, job->period);
+      shell_watch_print_args(job);
+      shell_puts("\r\n");
+    }
+  }
+}
+
+
+// find the command and copy the arguments into a free slot, so the line can be reused.
+static int shell_watch_add(unsigned int period, int argc, char *const argv[])
+{
+  shell_watch_job_t *job = NULL;
+  const shell_cmd_t *pCmdt;
+  size_t len, used = 0;
+  unsigned int i;
+
+  for (i = 0; i < CONFIG_SHELL_WATCH_JOBS; i++) {
+    if (shell_watch_jobs[i].cmd == NULL) {
+      job = &shell_watch_jobs[i];
+      break;
+    }
+  }
+  if (job == NULL) {
+    shell_puts("  watch: too many jobs.\r\n");
+    return -1;
+  }
+
+  pCmdt = shell_find_top_cmd(argv[0]);
+#if CONFIG_SHELL_CMD_ABBREV
+  if (pCmdt == NULL && shell_find_top_cmd_prefix(argv[0], &pCmdt) != 1) {
+    pCmdt = NULL;
+  }
+#endif /* CONFIG_SHELL_CMD_ABBREV */
+  if (pCmdt == NULL) {
+    shell_printf("  %s: command not found.\r\n", argv[0]);
+    return -1;
+  }
+
+  for (i = 0; i < (unsigned int)argc; i++) {
+    len = strlen(argv[i]) + 1;
+    if (used + len > sizeof(job->args)) {
+      shell_puts("  watch: arguments too long.\r\n");
+      return -1;
+    }
+    memcpy(&job->args[used], argv[i], len);
+    job->argv[i] = &job->args[used];
+    used += len;
+  }
+  job->argv[argc] = NULL;
+  job->argc = argc;
+  job->period = period;
+  job->next = shell_tick_ms();  // run it at once.
+  job->cmd = pCmdt;
+
+  return 0;
+}
+
+
+int shell_cmd_watch(const shell_cmd_t *pcmd, int argc, char *const argv[])
+{
+  unsigned long value;
+  unsigned int period = SHELL_WATCH_DEFAULT_PERIOD;
+  char *end;
+
+  (void)pcmd;
+
+  if (argc == 1) {
+    shell_watch_list();
+    return 0;
+  }
+
+  if (strcmp(argv[1], "-k") == 0) {
+    if (argc == 2) {
+      shell_watch_kill(0, CONFIG_SHELL_WATCH_JOBS - 1);
+      return 0;
+    }
+    value = strtoul(argv[2], &end, 0);
+    if (*end || value >= CONFIG_SHELL_WATCH_JOBS || !shell_watch_kill(value, value)) {
+      shell_printf("  watch: %s: no such job.\r\n", argv[2]);
+      return -1;
+    }
+    return 0;
+  }
+
+  if (strcmp(argv[1], "-n") == 0) {
+    value = (argc > 2) ? strtoul(argv[2], &end, 0) : 0;
+    if (value == 0 || value > 0x7FFFFFFFUL || *end) {
+      shell_puts("  watch: invalid interval.\r\n");
+      return -1;
+    }
+    period = (unsigned int)value;
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc < 2) {
+    shell_puts("  watch: no command.\r\n");
+    return -1;
+  }
+
+  return shell_watch_add(period, argc - 1, argv + 1);
+}
+
+NANO_SHELL_ADD_CMD(watch,
+                   shell_cmd_watch,
+                   "watch [-n ms] command [args ...] | watch -k [job]",
+
+                   "    Run a command periodically (every 1000ms by default), and redraw its output.\r\n"
+                   "    The output of all the jobs is redrawn when one of them is due.\r\n"
+                   "\r\n"
+                   "    The command keeps running in the background while you type, press Ctrl-C\r\n"
+                   "    to stop all the jobs. Without arguments, list the jobs.\r\n"
+                   "\r\n"
+                   "    Options:\r\n"
+                   "        -n MS: interval in milliseconds\r\n"
+                   "        -k [JOB]: stop the job JOB, or all the jobs\r\n");
+
+#endif /* CONFIG_SHELL_CMD_WATCH */
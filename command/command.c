@@ -9,15 +9,175 @@
  *
  */
 
+#include <stdint.h>
 #include <string.h>
 
 #include "shell_io/shell_io.h"
+#include "parse/text_parse.h"
 #include "command.h"
 
+#if CONFIG_SHELL_CMD_ABBREV && !CONFIG_SHELL_CMD_PATH_RESOLVE
+#error "CONFIG_SHELL_CMD_ABBREV requires CONFIG_SHELL_CMD_PATH_RESOLVE."
+#endif
+
+/**
+ * the entries of the nano_shell sections (shell_cmd_t, shell_func_t) all begin with their name, so
+ * the sorted check and the binary search are shared by the tables of different types.
+ */
+#define SHELL_ENTRY_NAME(_start, _size, _i) \
+  (*(const char *const *)((const char *)(_start) + (size_t)(_i) * (_size)))
+
+static int shell_is_sorted_by_name(const void *start, unsigned int count, size_t size)
+{
+  for (unsigned int i = 1; i < count; i++) {
+    if (strcmp(SHELL_ENTRY_NAME(start, size, i - 1), SHELL_ENTRY_NAME(start, size, i)) > 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static const void *shell_find_by_name(const char *name, const void *start, unsigned int count, size_t size)
+{
+  unsigned int low = 0, high = count;
+
+  while (low < high) {
+    unsigned int mid = (low + high) >> 1;
+    int result = strcmp(name, SHELL_ENTRY_NAME(start, size, mid));
+
+    if (result == 0) {
+      return (const char *)start + (size_t)mid * size;
+    } else if (result < 0) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return NULL;
+}
+
+
+#if CONFIG_SHELL_CMD_FAST_LOOKUP
+
+/**
+ * state of the top-level command lookup:
+ *   0: unknown, the command table has not been checked yet.
+ *   1: the command table is sorted by the linker, search it directly.
+ *   2: the command table is not sorted, search `_shell_cmd_index`.
+ *  -1: neither of above, fall back to linear scan.
+ */
+static signed char _shell_lookup_mode;
+
+#if CONFIG_SHELL_CMD_LOOKUP_INDEX > 0
+// pointers to the entries of the command table, sorted by name.
+static const shell_cmd_t *_shell_cmd_index[CONFIG_SHELL_CMD_LOOKUP_INDEX];
+
+// build the sorted index (insertion sort, run only once).
+static void shell_build_cmd_index(const shell_cmd_t *start, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++) {
+    unsigned int j = i;
+    while (j > 0 && strcmp(_shell_cmd_index[j - 1]->name, start[i].name) > 0) {
+      _shell_cmd_index[j] = _shell_cmd_index[j - 1];
+      j--;
+    }
+    _shell_cmd_index[j] = &start[i];
+  }
+}
+
+static const shell_cmd_t *shell_find_indexed_cmd(const char *cmd_name, unsigned int count)
+{
+  unsigned int low = 0, high = count;
+
+  while (low < high) {
+    unsigned int mid = (low + high) >> 1;
+    int result = strcmp(cmd_name, _shell_cmd_index[mid]->name);
+
+    if (result == 0) {
+      return _shell_cmd_index[mid];
+    } else if (result < 0) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return NULL;
+}
+
+// find the entries of `_shell_cmd_index` starting with `prefix`, they are contiguous from `*begin`.
+static unsigned int shell_find_indexed_prefix(const char *prefix, unsigned int count, unsigned int *begin)
+{
+  size_t len = strlen(prefix);
+  unsigned int low = 0, high = count;
+
+  // the first entry not less than `prefix`
+  while (low < high) {
+    unsigned int mid = (low + high) >> 1;
+    if (strcmp(_shell_cmd_index[mid]->name, prefix) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  *begin = low;
+
+  // the end of the matched entries
+  high = count;
+  while (low < high) {
+    unsigned int mid = (low + high) >> 1;
+    if (strncmp(_shell_cmd_index[mid]->name, prefix, len) == 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low - *begin;
+}
+#endif /* CONFIG_SHELL_CMD_LOOKUP_INDEX > 0 */
+
+static void shell_init_lookup(const shell_cmd_t *start, unsigned int count)
+{
+  if (shell_is_cmds_sorted(start, count)) {
+    _shell_lookup_mode = 1;
+  }
+#if CONFIG_SHELL_CMD_LOOKUP_INDEX > 0
+  else if (count <= CONFIG_SHELL_CMD_LOOKUP_INDEX) {
+    shell_build_cmd_index(start, count);
+    _shell_lookup_mode = 2;
+  }
+#endif /* CONFIG_SHELL_CMD_LOOKUP_INDEX > 0 */
+  else {
+    _shell_lookup_mode = -1;
+  }
+}
+
+#endif /* CONFIG_SHELL_CMD_FAST_LOOKUP */
+
+
 const shell_cmd_t *shell_find_top_cmd(const char *cmd_name)
 {
   const shell_cmd_t *start = _shell_entry_start(shell_cmd_t);
   unsigned int count = _shell_entry_count(shell_cmd_t);
+
+#if CONFIG_SHELL_CMD_FAST_LOOKUP
+  if (cmd_name == NULL) {
+    return NULL;
+  }
+
+  if (_shell_lookup_mode == 0) {
+    shell_init_lookup(start, count);
+  }
+
+  if (_shell_lookup_mode == 1) {
+    return shell_find_sorted_cmd(cmd_name, start, count);
+  }
+#if CONFIG_SHELL_CMD_LOOKUP_INDEX > 0
+  else if (_shell_lookup_mode == 2) {
+    return shell_find_indexed_cmd(cmd_name, count);
+  }
+#endif /* CONFIG_SHELL_CMD_LOOKUP_INDEX > 0 */
+#endif /* CONFIG_SHELL_CMD_FAST_LOOKUP */
+
   return shell_find_cmd(cmd_name, start, count);
 }
 
@@ -39,29 +199,126 @@ const shell_cmd_t *shell_find_cmd(const char *cmd_name, const shell_cmd_t* start
   return NULL;
 }
 
+const shell_cmd_t *shell_find_sorted_cmd(const char *cmd_name, const shell_cmd_t* start, unsigned int count)
+{
+  if (cmd_name == NULL || start == NULL) {
+    return NULL;
+  }
+
+  return shell_find_by_name(cmd_name, start, count, sizeof(shell_cmd_t));
+}
+
+unsigned int shell_find_cmd_prefix(const char *prefix, const shell_cmd_t* start, unsigned int count,
+                                   int sorted, const shell_cmd_t **first)
+{
+  size_t len = strlen(prefix);
+  unsigned int low = 0, high = count, begin;
+
+  *first = NULL;
+
+  if (!sorted) {
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < count; i++) {
+      if (strncmp(start[i].name, prefix, len) == 0) {
+        if (n++ == 0) {
+          *first = &start[i];
+        }
+      }
+    }
+    return n;
+  }
+
+  // the first entry not less than `prefix`
+  while (low < high) {
+    unsigned int mid = (low + high) >> 1;
+    if (strcmp(start[mid].name, prefix) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  begin = low;
+
+  // the matched entries are contiguous from `begin`, find the end of them.
+  high = count;
+  while (low < high) {
+    unsigned int mid = (low + high) >> 1;
+    if (strncmp(start[mid].name, prefix, len) == 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  if (low > begin) {
+    *first = &start[begin];
+  }
+  return low - begin;
+}
+
+int shell_is_cmds_sorted(const shell_cmd_t* start, unsigned int count)
+{
+  return shell_is_sorted_by_name(start, count, sizeof(shell_cmd_t));
+}
+
+
+// return the state of the top-level command lookup (see `_shell_lookup_mode`), -1 if linear scan.
+static int shell_top_lookup_mode(void)
+{
+#if CONFIG_SHELL_CMD_FAST_LOOKUP
+  if (_shell_lookup_mode == 0) {
+    shell_init_lookup(_shell_entry_start(shell_cmd_t), _shell_entry_count(shell_cmd_t));
+  }
+  return _shell_lookup_mode;
+#else
+  return -1;
+#endif /* CONFIG_SHELL_CMD_FAST_LOOKUP */
+}
+
+unsigned int shell_find_top_cmd_prefix(const char *prefix, const shell_cmd_t **first)
+{
+  const shell_cmd_t *start = _shell_entry_start(shell_cmd_t);
+  unsigned int count = _shell_entry_count(shell_cmd_t);
+  int mode = shell_top_lookup_mode();
+
+#if CONFIG_SHELL_CMD_FAST_LOOKUP && CONFIG_SHELL_CMD_LOOKUP_INDEX > 0
+  if (mode == 2) {
+    unsigned int begin, n = shell_find_indexed_prefix(prefix, count, &begin);
+
+    *first = n ? _shell_cmd_index[begin] : NULL;
+    return n;
+  }
+#endif /* CONFIG_SHELL_CMD_LOOKUP_INDEX > 0 */
+
+  return shell_find_cmd_prefix(prefix, start, count, mode == 1, first);
+}
+
 
 int shell_run_cmd(int argc, char *const argv[])
 {
+#if CONFIG_SHELL_CMD_PATH_RESOLVE
+  if (argc > 0) {
+    return shell_resolve_and_run(argc, argv);
+  }
+#else
   if (argc > 0) {
     const shell_cmd_t *pCmdt = shell_find_top_cmd(argv[0]);
 
     if (pCmdt) {
-      return pCmdt->cmd(pCmdt, argc, argv);
+      return shell_cmd_run_measured(pCmdt, pCmdt->cmd, argc, argv);
     }
 
     shell_printf("  %s: command not found.\r\n", argv[0]);
   }
+#endif /* CONFIG_SHELL_CMD_PATH_RESOLVE */
   return -1;
 }
 
-int shell_run_subcmd_implem(const shell_cmd_t* pCmdt,
+static int shell_dispatch_subcmd(const shell_cmd_t* pCmdt, const shell_cmd_t* pSubCmdt,
                 int argc, char* const argv[],
-                shell_cmd_cb_t fallback_fct,
-                const shell_cmd_t* subcommands, unsigned int  subcommands_count)
+                shell_cmd_cb_t fallback_fct)
 {
   if (argc > 1) {
-    const shell_cmd_t* pSubCmdt = shell_find_cmd(argv[1], subcommands, subcommands_count);
-
     if (pSubCmdt) {
       return pSubCmdt->cmd(pSubCmdt, argc - 1, argv + 1);
     }
@@ -78,3 +335,392 @@ int shell_run_subcmd_implem(const shell_cmd_t* pCmdt,
 
   return -1;
 }
+
+int shell_run_subcmd_implem(const shell_cmd_t* pCmdt,
+                int argc, char* const argv[],
+                shell_cmd_cb_t fallback_fct,
+                const shell_cmd_t* subcommands, unsigned int  subcommands_count)
+{
+  const shell_cmd_t* pSubCmdt = NULL;
+
+  if (argc > 1) {
+    pSubCmdt = shell_find_cmd(argv[1], subcommands, subcommands_count);
+  }
+  return shell_dispatch_subcmd(pCmdt, pSubCmdt, argc, argv, fallback_fct);
+}
+
+// check the order of a group defined by NANO_SHELL_DEFINE_SORTED_SUBCMDS() once.
+static void shell_check_sorted_subcmds(const shell_cmd_t* pCmdt,
+                const shell_cmd_t* subcommands, unsigned int  subcommands_count,
+                signed char *sorted_state)
+{
+  // the built-in 'help' sub-command is always the first one, skip it when checking the order.
+  if (*sorted_state == 0) {
+    if (shell_is_cmds_sorted(subcommands + _shell_help_subcmd_count,
+                             subcommands_count - _shell_help_subcmd_count)) {
+      *sorted_state = 1;
+    } else {
+      *sorted_state = -1;
+      shell_printf("** WARNING: sub-commands of \"%s\" are not sorted, "
+                   "fall back to linear search. **\r\n", pCmdt->name);
+    }
+  }
+}
+
+// find `cmd_name` in a group defined by NANO_SHELL_DEFINE_SORTED_SUBCMDS().
+static const shell_cmd_t *shell_find_sorted_subcmd(const char *cmd_name, const shell_cmd_t* pCmdt,
+                const shell_cmd_t* subcommands, unsigned int  subcommands_count,
+                signed char *sorted_state)
+{
+  shell_check_sorted_subcmds(pCmdt, subcommands, subcommands_count, sorted_state);
+
+  if (*sorted_state < 0) {
+    return shell_find_cmd(cmd_name, subcommands, subcommands_count);
+  }
+#if CONFIG_SHELL_CMD_BUILTIN_HELP
+  if (strcmp(cmd_name, subcommands->name) == 0) {
+    return subcommands;
+  }
+#endif /* CONFIG_SHELL_CMD_BUILTIN_HELP */
+  return shell_find_sorted_cmd(cmd_name, subcommands + _shell_help_subcmd_count,
+                               subcommands_count - _shell_help_subcmd_count);
+}
+
+int shell_run_sorted_subcmd_implem(const shell_cmd_t* pCmdt,
+                int argc, char* const argv[],
+                shell_cmd_cb_t fallback_fct,
+                const shell_cmd_t* subcommands, unsigned int  subcommands_count,
+                signed char *sorted_state)
+{
+  const shell_cmd_t* pSubCmdt = NULL;
+
+  if (argc > 1) {
+    pSubCmdt = shell_find_sorted_subcmd(argv[1], pCmdt, subcommands, subcommands_count, sorted_state);
+  }
+  return shell_dispatch_subcmd(pCmdt, pSubCmdt, argc, argv, fallback_fct);
+}
+
+
+#if CONFIG_SHELL_CMD_PATH_RESOLVE
+
+#if CONFIG_SHELL_CMD_GROUP_INDEX > 0
+/**
+ * state of the group lookup:
+ *   0: unknown, the index has not been built yet.
+ *   1: search `_shell_group_index`.
+ *  -1: too many groups, fall back to linear scan.
+ */
+static signed char _shell_group_mode;
+
+// pointers to the groups of sub-commands, sorted by the address of their function.
+static const shell_subcmds_t *_shell_group_index[CONFIG_SHELL_CMD_GROUP_INDEX];
+
+#define SHELL_FCT_ADDR(fct) ((uintptr_t)(fct))
+
+// build the sorted index (insertion sort, run only once).
+static void shell_build_group_index(const shell_subcmds_t *start, unsigned int count)
+{
+  if (count > CONFIG_SHELL_CMD_GROUP_INDEX) {
+    _shell_group_mode = -1;
+    return;
+  }
+
+  for (unsigned int i = 0; i < count; i++) {
+    unsigned int j = i;
+    while (j > 0 && SHELL_FCT_ADDR(_shell_group_index[j - 1]->fct) > SHELL_FCT_ADDR(start[i].fct)) {
+      _shell_group_index[j] = _shell_group_index[j - 1];
+      j--;
+    }
+    _shell_group_index[j] = &start[i];
+  }
+  _shell_group_mode = 1;
+}
+
+static const shell_subcmds_t *shell_find_indexed_group(shell_cmd_cb_t fct, unsigned int count)
+{
+  unsigned int low = 0, high = count;
+
+  while (low < high) {
+    unsigned int mid = (low + high) >> 1;
+    uintptr_t addr = SHELL_FCT_ADDR(_shell_group_index[mid]->fct);
+
+    if (SHELL_FCT_ADDR(fct) == addr) {
+      return _shell_group_index[mid];
+    } else if (SHELL_FCT_ADDR(fct) < addr) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return NULL;
+}
+#endif /* CONFIG_SHELL_CMD_GROUP_INDEX > 0 */
+
+const shell_subcmds_t *shell_find_subcmds(shell_cmd_cb_t fct)
+{
+  const shell_subcmds_t *tmp = _shell_entry_start(shell_subcmds_t);
+  unsigned int count = _shell_entry_count(shell_subcmds_t);
+
+#if CONFIG_SHELL_CMD_GROUP_INDEX > 0
+  if (_shell_group_mode == 0) {
+    shell_build_group_index(tmp, count);
+  }
+
+  if (_shell_group_mode == 1) {
+    return shell_find_indexed_group(fct, count);
+  }
+#endif /* CONFIG_SHELL_CMD_GROUP_INDEX > 0 */
+
+  while (count) {
+    if (tmp->fct == fct) {
+      return tmp;
+    }
+    count--;
+    tmp++;
+  }
+  return NULL;
+}
+
+/**
+ * find `cmd_name` in the top-level commands (pCmdt == NULL) or in a group of sub-commands.
+ * return the number of matched commands: 0: not found, 1: found, >1: ambiguous abbreviation.
+ */
+static unsigned int shell_lookup(const char *cmd_name, const shell_cmd_t* pCmdt,
+                const shell_subcmds_t *group, const shell_cmd_t **match)
+{
+  if (group == NULL) {
+    *match = shell_find_top_cmd(cmd_name);
+  } else if (group->sorted_state) {
+    *match = shell_find_sorted_subcmd(cmd_name, pCmdt, group->subcommands, group->count,
+                                      group->sorted_state);
+  } else {
+    *match = shell_find_cmd(cmd_name, group->subcommands, group->count);
+  }
+
+  if (*match) {
+    return 1;
+  }
+
+#if CONFIG_SHELL_CMD_ABBREV
+  if (group == NULL) {
+    return shell_find_top_cmd_prefix(cmd_name, match);
+  } else if (group->sorted_state && *group->sorted_state > 0) {
+    const shell_cmd_t *first = NULL;
+    unsigned int n = shell_find_cmd_prefix(cmd_name, group->subcommands + _shell_help_subcmd_count,
+                                           group->count - _shell_help_subcmd_count, 1, &first);
+#if CONFIG_SHELL_CMD_BUILTIN_HELP
+    if (strncmp(group->subcommands->name, cmd_name, strlen(cmd_name)) == 0) {
+      first = group->subcommands;
+      n++;
+    }
+#endif /* CONFIG_SHELL_CMD_BUILTIN_HELP */
+    *match = first;
+    return n;
+  } else {
+    return shell_find_cmd_prefix(cmd_name, group->subcommands, group->count, 0, match);
+  }
+#else
+  return 0;
+#endif /* CONFIG_SHELL_CMD_ABBREV */
+}
+
+// descend from the top-level command `pCmdt` while the current command is a group of sub-commands.
+static int shell_descend_and_run(const shell_cmd_t *pCmdt, int argc, char *const argv[])
+{
+  const shell_cmd_t *pSubCmdt;
+  const shell_subcmds_t *group;
+  unsigned int n;
+
+  while ((group = shell_find_subcmds(pCmdt->cmd)) != NULL) {
+    if (argc > 1) {
+      n = shell_lookup(argv[1], pCmdt, group, &pSubCmdt);
+      if (n == 1) {
+        pCmdt = pSubCmdt;
+        argc--;
+        argv++;
+        continue;
+      } else if (n > 1) {
+        shell_printf("  %s: ambiguous sub-command.\r\n", argv[1]);
+        return -1;
+      }
+    }
+    return shell_dispatch_subcmd(pCmdt, NULL, argc, argv, group->fallback);
+  }
+
+  return pCmdt->cmd(pCmdt, argc, argv);
+}
+
+int shell_resolve_and_run(int argc, char *const argv[])
+{
+  const shell_cmd_t *pCmdt;
+  unsigned int n = shell_lookup(argv[0], NULL, NULL, &pCmdt);
+
+  if (n != 1) {
+    shell_printf(n ? "  %s: ambiguous command.\r\n" : "  %s: command not found.\r\n", argv[0]);
+    return -1;
+  }
+
+  return shell_cmd_run_measured(pCmdt, shell_descend_and_run, argc, argv);
+}
+
+#endif /* CONFIG_SHELL_CMD_PATH_RESOLVE */
+
+
+#if CONFIG_SHELL_TAB_COMPLETION
+
+// visit the commands starting with `prefix`, return the number of them.
+static unsigned int shell_visit_prefix(const char *prefix,
+                const shell_cmd_t* start, unsigned int count, int sorted,
+                shell_cmd_visit_t visit, void *arg)
+{
+  const shell_cmd_t *first;
+  unsigned int n = shell_find_cmd_prefix(prefix, start, count, sorted, &first);
+
+  if (sorted) {
+    for (unsigned int i = 0; i < n; i++) {
+      visit(&first[i], arg);
+    }
+  } else if (n) {
+    size_t len = strlen(prefix);
+    for (; first < start + count; first++) {
+      if (strncmp(first->name, prefix, len) == 0) {
+        visit(first, arg);
+      }
+    }
+  }
+  return n;
+}
+
+unsigned int shell_complete_cmd(int argc, char *const argv[], const char *prefix,
+                                shell_cmd_visit_t visit, void *arg)
+{
+  if (argc == 0) {
+    const shell_cmd_t *start = _shell_entry_start(shell_cmd_t);
+    unsigned int count = _shell_entry_count(shell_cmd_t);
+    int mode = shell_top_lookup_mode();
+
+#if CONFIG_SHELL_CMD_FAST_LOOKUP && CONFIG_SHELL_CMD_LOOKUP_INDEX > 0
+    if (mode == 2) {  // the matched commands are contiguous in the index.
+      unsigned int begin, n = shell_find_indexed_prefix(prefix, count, &begin);
+
+      for (unsigned int i = 0; i < n; i++) {
+        visit(_shell_cmd_index[begin + i], arg);
+      }
+      return n;
+    }
+#endif /* CONFIG_SHELL_CMD_LOOKUP_INDEX > 0 */
+
+    return shell_visit_prefix(prefix, start, count, mode == 1, visit, arg);
+  }
+
+#if CONFIG_SHELL_CMD_PATH_RESOLVE
+  {
+    const shell_cmd_t *pCmdt = NULL;
+    const shell_subcmds_t *group = NULL;
+    unsigned int n = 0;
+
+    // walk the path, only groups of sub-commands can be completed.
+    for (int i = 0; i < argc; i++) {
+      if (shell_lookup(argv[i], pCmdt, group, &pCmdt) != 1 ||
+          (group = shell_find_subcmds(pCmdt->cmd)) == NULL) {
+        return 0;
+      }
+    }
+
+    if (group->sorted_state) {
+      shell_check_sorted_subcmds(pCmdt, group->subcommands, group->count, group->sorted_state);
+    }
+    if (group->sorted_state == NULL || *group->sorted_state < 0) {
+      return shell_visit_prefix(prefix, group->subcommands, group->count, 0, visit, arg);
+    }
+
+#if CONFIG_SHELL_CMD_BUILTIN_HELP
+    if (strncmp(group->subcommands->name, prefix, strlen(prefix)) == 0) {
+      visit(group->subcommands, arg);
+      n++;
+    }
+#endif /* CONFIG_SHELL_CMD_BUILTIN_HELP */
+    return n + shell_visit_prefix(prefix, group->subcommands + _shell_help_subcmd_count,
+                                  group->count - _shell_help_subcmd_count, 1, visit, arg);
+  }
+#else
+  (void)argv;
+  return 0;
+#endif /* CONFIG_SHELL_CMD_PATH_RESOLVE */
+}
+
+#endif /* CONFIG_SHELL_TAB_COMPLETION */
+
+
+#if CONFIG_SHELL_FUNC_CALL
+
+const shell_func_t *shell_find_func(const char *func_name)
+{
+  // 0: unknown, 1: sorted by the linker, -1: not sorted.
+  static signed char sorted;
+
+  const shell_func_t *start = _shell_entry_start(shell_func_t);
+  unsigned int count = _shell_entry_count(shell_func_t);
+
+  if (sorted == 0) {
+    sorted = shell_is_sorted_by_name(start, count, sizeof(shell_func_t)) ? 1 : -1;
+  }
+
+  if (sorted > 0) {
+    return shell_find_by_name(func_name, start, count, sizeof(shell_func_t));
+  }
+
+  for (; count; count--, start++) {
+    if (strcmp(func_name, start->name) == 0) {
+      return start;
+    }
+  }
+  return NULL;
+}
+
+int shell_call_func(const shell_func_t *pFunc, int argc, char *const argv[], int *result)
+{
+  intptr_t arg[SHELL_FUNC_MAX_PARAM];
+
+  if (pFunc->param_n > SHELL_FUNC_MAX_PARAM) {
+    shell_printf("  %s: too many parameters (max: %d).\r\n", pFunc->name, SHELL_FUNC_MAX_PARAM);
+    return -1;
+  }
+  if (argc - 1 != pFunc->param_n) {
+    shell_printf("  %s: takes %d arguments, but %d given.\r\n", pFunc->name, pFunc->param_n, argc - 1);
+    return -1;
+  }
+
+  /**
+   * numbers are converted straight to register-sized values, a single character is passed as
+   * its code, and any other argument is passed as a pointer to the string.
+   */
+  for (int i = 0; i < pFunc->param_n; i++) {
+    const char *str = argv[i + 1];
+    long num;
+
+    if (nano_shell_parse_num(str, &num)) {
+      arg[i] = (intptr_t)num;
+    } else {
+      arg[i] = (str[0] && !str[1]) ? (intptr_t)(unsigned char)str[0] : (intptr_t)str;
+    }
+  }
+
+  // `param_n` selects the member set by NANO_SHELL_ADD_FUNC(), so the call matches the prototype.
+  switch (pFunc->param_n) {
+    case 0: *result = pFunc->func.f0(); break;
+    case 1: *result = pFunc->func.f1(arg[0]); break;
+    case 2: *result = pFunc->func.f2(arg[0], arg[1]); break;
+    case 3: *result = pFunc->func.f3(arg[0], arg[1], arg[2]); break;
+    case 4: *result = pFunc->func.f4(arg[0], arg[1], arg[2], arg[3]); break;
+    case 5: *result = pFunc->func.f5(arg[0], arg[1], arg[2], arg[3], arg[4]); break;
+    case 6: *result = pFunc->func.f6(arg[0], arg[1], arg[2], arg[3], arg[4], arg[5]); break;
+    case 7: *result = pFunc->func.f7(arg[0], arg[1], arg[2], arg[3], arg[4], arg[5], arg[6]); break;
+    default:
+      *result = pFunc->func.f8(arg[0], arg[1], arg[2], arg[3], arg[4], arg[5], arg[6], arg[7]);
+      break;
+  }
+  return 0;
+}
+
+#endif /* CONFIG_SHELL_FUNC_CALL */
@@ -12,10 +12,17 @@
 #ifndef __NANO_SHELL_COMMAND_H
 #define __NANO_SHELL_COMMAND_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "shell_linker.h"
 
 #include "shell_config.h"
 
+#if CONFIG_SHELL_CMD_ARG_SPEC
+#include "parse/arg_parse.h"
+#endif /* CONFIG_SHELL_CMD_ARG_SPEC */
+
 // Forward delecation of shell command structure
 struct _shell_cmd_s;
 
@@ -44,16 +51,33 @@ typedef struct _shell_cmd_s {
 #if CONFIG_SHELL_CMD_LONG_HELP
   const char *help;  // detailed help information of the command.
 #endif
+
+#if CONFIG_SHELL_CMD_ARG_SPEC
+  const shell_arg_spec_t *args;  // argument specifications of the command, can be NULL.
+#endif
 } shell_cmd_t;
 
 
+// prototypes of the functions added by @ref NANO_SHELL_ADD_FUNC(), by the number of parameters.
+typedef union {
+  int (*f0)(void);
+  int (*f1)(intptr_t);
+  int (*f2)(intptr_t, intptr_t);
+  int (*f3)(intptr_t, intptr_t, intptr_t);
+  int (*f4)(intptr_t, intptr_t, intptr_t, intptr_t);
+  int (*f5)(intptr_t, intptr_t, intptr_t, intptr_t, intptr_t);
+  int (*f6)(intptr_t, intptr_t, intptr_t, intptr_t, intptr_t, intptr_t);
+  int (*f7)(intptr_t, intptr_t, intptr_t, intptr_t, intptr_t, intptr_t, intptr_t);
+  int (*f8)(intptr_t, intptr_t, intptr_t, intptr_t, intptr_t, intptr_t, intptr_t, intptr_t);
+} shell_func_ptr_t;
+
 // shell function structure
 typedef struct {
   const char *name;  // function name
 
   const int param_n; // number of parameters
 
-  int (*func)(); // function pointr.
+  shell_func_ptr_t func; // function pointr, the member `f<param_n>` is set.
 
 #if CONFIG_SHELL_FUNC_BRIEF_USAGE
   const char *brief;  // brief summaries of the command.
@@ -61,6 +85,135 @@ typedef struct {
 } shell_func_t;
 
 
+// descriptor of a group of sub-commands, see @ref NANO_SHELL_DEFINE_SUBCMDS()
+typedef struct {
+  shell_cmd_cb_t fct;       // NANO_SHELL_SUBCMDS_FCT() of the group
+
+  shell_cmd_cb_t fallback;  // fallback function of the group, can be NULL
+
+  const shell_cmd_t *subcommands;  // the sub-commands, the built-in 'help' (if enabled) first
+
+  unsigned int count;  // number of entries in `subcommands`
+
+  signed char *sorted_state;  // NULL if the group is not defined as sorted
+} shell_subcmds_t;
+
+
+#if CONFIG_SHELL_CMD_TASK
+/**
+ * @brief state of a resumable command, see @ref NANO_SHELL_ADD_TASK_CMD().
+ *        only `cancelled` and the state (@ref NANO_SHELL_TASK_STATE()) are for the command.
+ */
+typedef struct _shell_task_s {
+  int lc;  // where to resume, 0 at the first call
+
+  int cancelled;  // non-zero when Ctrl-C is pressed, the command is called once more to clean up.
+
+  int (*fn)(struct _shell_task_s *task, int argc, char *const argv[]);  // NULL if no command is running
+
+  union {
+    long l;
+    void *p;
+    double d;
+    char c[CONFIG_SHELL_CMD_TASK_STATE_SIZE];
+  } state;  // zeroed at the first call
+} shell_task_t;
+
+/**
+ * @brief this is the implementation function of a resumable command, it runs one step per call,
+ *        see @ref NANO_SHELL_TASK_BEGIN().
+ *
+ * @param task: the state of the command.
+ * @param argc: the count of arguments, 0 after the first call.
+ * @param argv: argument vector, only passed to the first call (NULL afterwards, the line buffer is
+ *              reused while the command runs), keep what you need in the state.
+ * @return NANO_SHELL_TASK_YIELDED to be called again, NANO_SHELL_TASK_EXITED when it is done.
+ */
+typedef int (*shell_task_cb_t)(shell_task_t *task, int argc, char *const argv[]);
+
+#define NANO_SHELL_TASK_EXITED 0
+#define NANO_SHELL_TASK_YIELDED 1
+
+/**
+ * @brief the body of a resumable command is written between NANO_SHELL_TASK_BEGIN() and
+ *        NANO_SHELL_TASK_END(), like a normal function which calls NANO_SHELL_YIELD() to let the
+ *        shell process the input (and the other work of your main loop) between the steps.
+ *
+ * @note the local variables are NOT preserved across NANO_SHELL_YIELD(), keep them in the state
+ *       (@ref NANO_SHELL_TASK_STATE()). don't use `switch` statements containing NANO_SHELL_YIELD().
+ *
+ * @example:
+ *   struct memtest { unsigned long addr, end; };
+ *
+ *   static int do_memtest(shell_task_t *task, int argc, char *const argv[])
+ *   {
+ *     struct memtest *s = NANO_SHELL_TASK_STATE(task, struct memtest);
+ *
+ *     NANO_SHELL_TASK_BEGIN(task);
+ *     s->addr = RAM_START;
+ *     s->end = RAM_END;
+ *     while (s->addr < s->end && !NANO_SHELL_TASK_CANCELLED(task)) {
+ *       test_block(s->addr);
+ *       s->addr += 1024;
+ *       NANO_SHELL_YIELD(task);
+ *     }
+ *     shell_printf("memtest %s at 0x%lx\r\n", NANO_SHELL_TASK_CANCELLED(task) ? "stopped" : "done", s->addr);
+ *     NANO_SHELL_TASK_END(task);
+ *   }
+ *   NANO_SHELL_ADD_TASK_CMD(memtest, do_memtest, "memtest", "");
+ */
+#define NANO_SHELL_TASK_BEGIN(task) \
+  switch ((task)->lc) {             \
+    case 0:
+
+#define NANO_SHELL_TASK_END(task) \
+  }                               \
+  (task)->lc = 0;                 \
+  return NANO_SHELL_TASK_EXITED
+
+// return to the shell, the command goes on from here at the next `nano_shell_poll()`.
+#define NANO_SHELL_YIELD(task)           \
+  do {                                   \
+    (task)->lc = __LINE__;               \
+    return NANO_SHELL_TASK_YIELDED;      \
+    case __LINE__:;                      \
+  } while (0)
+
+// yield until `cond` is true, `cond` is checked at every `nano_shell_poll()`.
+#define NANO_SHELL_YIELD_UNTIL(task, cond) \
+  do {                                     \
+    (task)->lc = __LINE__;                 \
+    case __LINE__:                         \
+    if (!(cond)) {                         \
+      return NANO_SHELL_TASK_YIELDED;      \
+    }                                      \
+  } while (0)
+
+// end the command here.
+#define NANO_SHELL_TASK_EXIT(task) \
+  do {                             \
+    (task)->lc = 0;                \
+    return NANO_SHELL_TASK_EXITED; \
+  } while (0)
+
+// non-zero if Ctrl-C is pressed: this is the last call, clean up and exit.
+#define NANO_SHELL_TASK_CANCELLED(task) ((task)->cancelled)
+
+// pointer to the state of the command as `type *`, sizeof(type) MUST be no more than CONFIG_SHELL_CMD_TASK_STATE_SIZE.
+#define NANO_SHELL_TASK_STATE(task, type) \
+  ((type *)(void *)((task)->state.c + 0 * sizeof(char[(sizeof(type) <= CONFIG_SHELL_CMD_TASK_STATE_SIZE) ? 1 : -1])))
+
+/**
+ * @brief start a resumable command and run its first step, the rest is run by `nano_shell_poll()`.
+ *        used by @ref NANO_SHELL_ADD_TASK_CMD(), call it in a normal command (or sub-command)
+ *        function to make it resumable.
+ *
+ * @return 0 if the command is started, -1 if another command is running.
+ */
+int nano_shell_task_start(shell_task_cb_t fn, int argc, char *const argv[]);
+#endif /* CONFIG_SHELL_CMD_TASK */
+
+
 #if CONFIG_SHELL_CMD_BRIEF_USAGE
   #define _CMD_BRIEF(x) x,
 #else
@@ -73,6 +226,12 @@ typedef struct {
   #define _CMD_HELP(x)
 #endif /* CONFIG_SHELL_CMD_LONG_HELP */
 
+#if CONFIG_SHELL_CMD_ARG_SPEC
+  #define _CMD_ARGS(x) x,
+#else
+  #define _CMD_ARGS(x)
+#endif /* CONFIG_SHELL_CMD_ARG_SPEC */
+
 #if CONFIG_SHELL_FUNC_BRIEF_USAGE
   #define _FUNC_BRIEF(x) x,
 #else
@@ -82,11 +241,14 @@ typedef struct {
 
 
 #define _shell_cmd_complete(_name, _func, _brief, _help) \
-  { #_name, _func, _CMD_BRIEF(_brief) _CMD_HELP(_help) }
+  { #_name, _func, _CMD_BRIEF(_brief) _CMD_HELP(_help) _CMD_ARGS(NULL) }
+
+#define _shell_cmd_complete_args(_name, _func, _args, _brief, _help) \
+  { #_name, _func, _CMD_BRIEF(_brief) _CMD_HELP(_help) _CMD_ARGS(_args) }
 
 
 #define _shell_func_complete(_name, _nparam, _func, _brief) \
-  { #_name, _nparam, _func, _FUNC_BRIEF(_brief) }
+  { #_name, _nparam, { .f ## _nparam = _func }, _FUNC_BRIEF(_brief) }
 
 
 /**
@@ -101,12 +263,49 @@ typedef struct {
   _shell_entry_declare(shell_cmd_t, _name) = _shell_cmd_complete(_name, _func, _brief, _help)
 
 
+#if CONFIG_SHELL_CMD_TASK
+/**
+ * @brief add a resumable command to nano-shell, it runs step by step while the shell keeps
+ *        processing the input, and can be cancelled by Ctrl-C.
+ *
+ * @_name: name of the command. Note: THIS IS NOT a string.
+ * @_func: function pointer: (*cmd)(shell_task_t *, int, char *const[]), see @ref NANO_SHELL_TASK_BEGIN().
+ * @_brief: brief summaries of the command. This is a string.
+ * @_help: detailed help information of the command. This is a string.
+ */
+#define NANO_SHELL_ADD_TASK_CMD(_name, _func, _brief, _help)                                  \
+  static int _name##_task_start(const shell_cmd_t *pCmdt, int argc, char *const argv[])     \
+  {                                                                                         \
+    (void)pCmdt;                                                                            \
+    return nano_shell_task_start(_func, argc, argv);                                        \
+  }                                                                                         \
+  NANO_SHELL_ADD_CMD(_name, _name##_task_start, _brief, _help)
+#endif /* CONFIG_SHELL_CMD_TASK */
+
+
+#if CONFIG_SHELL_CMD_ARG_SPEC
+/**
+ * @brief add a command with argument specifications to nano-shell
+ *
+ * @_name: name of the command. Note: THIS IS NOT a string.
+ * @_func: function pointer: (*cmd)(const shell_cmd_t *, int, int, char *const[]).
+ *         call shell_parse_args(pCmdt->args, argc, argv, &your_struct) in it to parse the arguments.
+ * @_args: array of shell_arg_spec_t, terminated by SHELL_ARG_END_ENTRY.
+ * @_brief: brief summaries of the command. This is a string.
+ * @_help: detailed help information of the command. This is a string.
+ */
+#define NANO_SHELL_ADD_CMD_ARGS(_name, _func, _args, _brief, _help) \
+  _shell_entry_declare(shell_cmd_t, _name) = _shell_cmd_complete_args(_name, _func, _args, _brief, _help)
+#endif /* CONFIG_SHELL_CMD_ARG_SPEC */
+
+
 /**
  * @brief add a function to nano-shell.
  *
  * @_name: name of the function. Note: THIS IS NOT a string.
- * @_nparam: param num of the function.
- * @_func: pointer of the function.
+ * @_nparam: param num of the function, a literal number from 0 to 8.
+ * @_func: pointer of the function, MUST be `int f(void)` or `int f(intptr_t, ...)` with `_nparam`
+ *         parameters of type intptr_t, the compiler checks it against @ref shell_func_ptr_t.
  * @_brief: brief summaries of the function. This is a string.
  */
 #define NANO_SHELL_ADD_FUNC(_name, _nparam, _func, _brief) \
@@ -134,12 +333,23 @@ typedef struct {
                       "Help for " #_name, \
                       _name ## _subcommands, subcommands_count); \
     }
+  #define _shell_help_subcmd_count 1U
 #else
   #define _shell_help_subcmd_entry(_name)
   #define _shell_help_subcmd_declare(_name)
   #define _shell_help_subcmd_define(_name)
+  #define _shell_help_subcmd_count 0U
 #endif  /* CONFIG_SHELL_CMD_BUILTIN_HELP */
 
+#if CONFIG_SHELL_CMD_PATH_RESOLVE
+  #define _shell_subcmds_register(_name, _fallback, _sorted_state) \
+    _shell_entry_declare(shell_subcmds_t, _name) = { \
+      NANO_SHELL_SUBCMDS_FCT(_name), _fallback, _name ## _subcommands, \
+      sizeof(_name ## _subcommands)/sizeof(shell_cmd_t), _sorted_state };
+#else
+  #define _shell_subcmds_register(_name, _fallback, _sorted_state)
+#endif /* CONFIG_SHELL_CMD_PATH_RESOLVE */
+
 /**
  * @brief Add a sub command in a group of sub-command
  *
@@ -153,6 +363,16 @@ typedef struct {
  */
 #define NANO_SHELL_SUBCMD_ENTRY(_name, _func, _brief, _help) _shell_cmd_complete(_name, _func, _brief, _help)
 
+#if CONFIG_SHELL_CMD_ARG_SPEC
+/**
+ * @brief Add a sub command with argument specifications in a group of sub-command
+ *
+ * The syntax is similar to @ref NANO_SHELL_ADD_CMD_ARGS()
+ */
+#define NANO_SHELL_SUBCMD_ENTRY_ARGS(_name, _func, _args, _brief, _help) \
+  _shell_cmd_complete_args(_name, _func, _args, _brief, _help)
+#endif /* CONFIG_SHELL_CMD_ARG_SPEC */
+
 
 /**
  * @brief Get the name of the function implementing a sub-command group in nano-shell
@@ -181,7 +401,35 @@ typedef struct {
     const unsigned int subcommands_count = sizeof(_name ## _subcommands)/sizeof(shell_cmd_t); \
     return shell_run_subcmd_implem(pCmd, argc, argv, \
       fallback_fct, _name ## _subcommands, subcommands_count); \
-  }
+  } \
+  _shell_subcmds_register(_name, fallback_fct, NULL)
+
+/**
+ * @brief Define a group of sub-commands sorted by name in nano-shell
+ *
+ * Same as @ref NANO_SHELL_DEFINE_SUBCMDS(), but the sub-commands are resolved with binary search.
+ * The order is checked once at the first call, if the sub-commands are not sorted, a warning is
+ * printed and the group falls back to linear search.
+ *
+ * @param _name name of the group of sub-commands
+ * @param fallback_fct: function that will be run if no subcommand can be found (either @c argc is 1 or argv[1] is not found in @c subcommand)
+ * @param ... A list of @ref NANO_SHELL_SUBCMD_ENTRY() that define the list of sub-commands,
+ *            MUST be sorted by name (in strcmp() order, for example, 'Zoom' < 'add' < 'add_ip' < 'addr').
+ */
+#define NANO_SHELL_DEFINE_SORTED_SUBCMDS(_name, fallback_fct, ...) \
+  _shell_help_subcmd_declare(_name) \
+  static  const shell_cmd_t _name ## _subcommands[] = { \
+          _shell_help_subcmd_entry(_name) \
+          __VA_ARGS__ }; \
+  _shell_help_subcmd_define(_name) \
+  static signed char _name ## _sorted_state; \
+  int NANO_SHELL_SUBCMDS_FCT(_name)(const shell_cmd_t* pCmd, int argc, char* const argv[]) \
+  { \
+    const unsigned int subcommands_count = sizeof(_name ## _subcommands)/sizeof(shell_cmd_t); \
+    return shell_run_sorted_subcmd_implem(pCmd, argc, argv, \
+      fallback_fct, _name ## _subcommands, subcommands_count, &_name ## _sorted_state); \
+  } \
+  _shell_subcmds_register(_name, fallback_fct, &_name ## _sorted_state)
 
 /**
  * @brief Find a shell command by name
@@ -205,6 +453,52 @@ const shell_cmd_t *shell_find_top_cmd(const char *cmd_name);
 const shell_cmd_t *shell_find_cmd(const char *cmd_name, const shell_cmd_t* cmds, unsigned int count);
 
 
+/**
+ * @brief Find a shell command by name in a list of commands sorted by name (binary search)
+ *
+ * @param cmd_name name of the shell command to search
+ * @param cmds list of commands to search, MUST be sorted by name (see @ref shell_is_cmds_sorted())
+ * @count number of entries in @c cmds
+ * @return const shell_cmd_t*
+ */
+const shell_cmd_t *shell_find_sorted_cmd(const char *cmd_name, const shell_cmd_t* cmds, unsigned int count);
+
+
+/**
+ * @brief Check whether a list of commands is sorted by name (in strcmp() order)
+ *
+ * @param cmds list of commands to check
+ * @count number of entries in @c cmds
+ * @return int 1: sorted, 0: not sorted.
+ */
+int shell_is_cmds_sorted(const shell_cmd_t* cmds, unsigned int count);
+
+
+/**
+ * @brief Find the shell commands whose name starts with @c prefix
+ *
+ * @param prefix the beginning of the command name
+ * @param cmds list of commands to search
+ * @param count number of entries in @c cmds
+ * @param sorted non-zero if @c cmds is sorted by name (binary search), else linear scan.
+ * @param first return the first matched command if there was...
+ * @return unsigned int the number of matched commands. if @c cmds is sorted, the matched
+ *         commands are contiguous: `(*first)[0]` ... `(*first)[n-1]`.
+ */
+unsigned int shell_find_cmd_prefix(const char *prefix, const shell_cmd_t* cmds, unsigned int count,
+                                   int sorted, const shell_cmd_t **first);
+
+
+/**
+ * @brief Find the top-level commands whose name starts with @c prefix
+ *
+ * @param prefix the beginning of the command name
+ * @param first return the first matched command if there was...
+ * @return unsigned int the number of matched commands, see @ref shell_find_cmd_prefix().
+ */
+unsigned int shell_find_top_cmd_prefix(const char *prefix, const shell_cmd_t **first);
+
+
 /**
  * @brief Run a shell command from a parsed line
  *
@@ -214,6 +508,79 @@ const shell_cmd_t *shell_find_cmd(const char *cmd_name, const shell_cmd_t* cmds,
  */
 int shell_run_cmd(int argc, char *const argv[]);
 
+#if CONFIG_SHELL_CMD_PATH_RESOLVE
+/**
+ * @brief Find the descriptor of a group of sub-commands by its function
+ *
+ * @param fct the function of the command, see @ref NANO_SHELL_SUBCMDS_FCT()
+ * @return const shell_subcmds_t* NULL if @c fct is not the function of a group of sub-commands.
+ */
+const shell_subcmds_t *shell_find_subcmds(shell_cmd_cb_t fct);
+
+/**
+ * @brief Resolve a command path (such as `net if eth0 stats`) and run the deepest handler.
+ *
+ * Walk the top-level commands and every group of sub-commands in a single loop, instead of
+ * going through the NANO_SHELL_SUBCMDS_FCT() of each level. The result is exactly the same as
+ * @ref shell_run_cmd(), except that unique prefixes are accepted if CONFIG_SHELL_CMD_ABBREV is enabled.
+ *
+ * @param argc: MUST be larger than 0
+ * @param argv
+ * @return int the return value of the handler, or -1 if not found.
+ */
+int shell_resolve_and_run(int argc, char *const argv[]);
+#endif /* CONFIG_SHELL_CMD_PATH_RESOLVE */
+
+#if CONFIG_SHELL_TAB_COMPLETION
+// callback of @ref shell_complete_cmd()
+typedef void (*shell_cmd_visit_t)(const shell_cmd_t *pCmdt, void *arg);
+
+/**
+ * @brief Find the candidates to complete the next word of a command line
+ *
+ * @param argc: the count of complete words before the word to be completed, can be 0.
+ * @param argv: the complete words, such as {"net", "if"}.
+ * @param prefix: the beginning of the word to be completed, can be "".
+ * @param visit: called for each candidate, in order of name if the list of commands is sorted (or indexed).
+ * @param arg: passed to @c visit
+ * @return unsigned int the number of candidates.
+ *
+ * @note sub-commands can be completed only if CONFIG_SHELL_CMD_PATH_RESOLVE is enabled.
+ */
+unsigned int shell_complete_cmd(int argc, char *const argv[], const char *prefix,
+                                shell_cmd_visit_t visit, void *arg);
+#endif /* CONFIG_SHELL_TAB_COMPLETION */
+
+#if CONFIG_SHELL_FUNC_CALL
+// max number of parameters of a function added by @ref NANO_SHELL_ADD_FUNC()
+#define SHELL_FUNC_MAX_PARAM 8
+
+/**
+ * @brief Find a shell function by name
+ *
+ * Find in the list of functions registred by @ref NANO_SHELL_ADD_FUNC().
+ *
+ * @param func_name name of the shell function to search
+ * @return const shell_func_t*
+ */
+const shell_func_t *shell_find_func(const char *func_name);
+
+/**
+ * @brief Call a shell function with the arguments in @c argv
+ *
+ * Each argument is passed as a register-sized value (intptr_t): decimal or hexadecimal numbers
+ * (such as `-12`, `0x4000`) are converted to numbers, a single character (such as `'a'`) is
+ * passed as its code, and other arguments are passed as a pointer to the string.
+ *
+ * @param pFunc: the function to be called.
+ * @param argc: the count of arguments, MUST be `pFunc->param_n + 1`.
+ * @param argv: argument vector, argv[0] is the function name.
+ * @param result: return the value returned by the function.
+ * @return 0 if the function has been called, else -1.
+ */
+int shell_call_func(const shell_func_t *pFunc, int argc, char *const argv[], int *result);
+#endif /* CONFIG_SHELL_FUNC_CALL */
+
 /**
  * @brief Implementation function for @ref NANO_SHELL_ADD_CMD_WITH_SUB
  *
@@ -231,6 +598,25 @@ int shell_run_subcmd_implem(const shell_cmd_t* pCmdt,
             shell_cmd_cb_t fallback_fct,
             const shell_cmd_t* subcommands, unsigned int  subcommands_count);
 
+/**
+ * @brief Implementation function for @ref NANO_SHELL_DEFINE_SORTED_SUBCMDS
+ *
+ * @param pCmdt: pointer of the structure.
+ * @param argc: the count of arguments.
+ * @param argv: argument vector.
+ * @param fallback_fct: function that will be run if no subcommand can be found (either @c argc is 1 or argv[1] is not found in @c subcommand)
+ * @param subcommands: a list of sub-commands, the built-in 'help' (if enabled) first, then sorted by name.
+ * @param subcommands_count: number of entries in @c subcommands
+ * @param sorted_state: 0 at the first call, then used to cache the result of the order check.
+ *
+ * @return 0 if succeed, else non-zero. (return value is not used in ver1.0)
+ */
+int shell_run_sorted_subcmd_implem(const shell_cmd_t* pCmdt,
+            int argc, char* const argv[],
+            shell_cmd_cb_t fallback_fct,
+            const shell_cmd_t* subcommands, unsigned int  subcommands_count,
+            signed char *sorted_state);
+
 /**
  * @brief Implementation function for 'help' command (or sub-command)
  *
@@ -246,4 +632,87 @@ int shell_help_generic(int argc, char *const argv[],
             const char* preamble,
             const shell_cmd_t* start, unsigned int count);
 
+
+#if CONFIG_SHELL_CMD_WATCH
+/**
+ * @brief a job of the built-in `watch` command: the command is looked up and the arguments are
+ *        parsed once, then the command is run every `period` milliseconds.
+ */
+typedef struct {
+  const shell_cmd_t *cmd;  // NULL if the slot is free
+  unsigned int period;     // ms
+  unsigned long next;      // tick (see `shell_tick_ms()`) of the next run
+  int argc;
+  char *argv[CONFIG_SHELL_CMD_MAX_ARGC + 1];
+  char args[CONFIG_SHELL_WATCH_ARGS_SIZE];  // the arguments, separated by '\0'
+} shell_watch_job_t;
+
+/**
+ * @brief run the `watch` jobs which are due, and redraw their output. called by `nano_shell_poll()`.
+ *
+ */
+void shell_watch_run(void);
+
+/**
+ * @brief the time (ms) until the next `watch` job is due, 0 if a job is due, ~0U if there is no job.
+ *
+ */
+unsigned int shell_watch_next(void);
+
+/**
+ * @brief cancel all the `watch` jobs (Ctrl-C), the input line is kept.
+ *
+ * @return the number of cancelled jobs.
+ */
+unsigned int shell_watch_cancel(void);
+#endif /* CONFIG_SHELL_CMD_WATCH */
+
+
+#if CONFIG_SHELL_CMD_STATS > 0
+/**
+ * @brief execution statistics of a top-level command, kept in a table parallel to the command
+ *        table (the nano_shell section). the time is counted by `shell_cycle_counter()`.
+ */
+typedef struct {
+  unsigned long calls;
+  unsigned long min;        // cycles
+  unsigned long max;        // cycles
+  unsigned long bytes;      // characters sent to the console
+  unsigned long long total; // cycles
+} shell_cmd_stats_t;
+
+// the counters when a command starts, see @ref shell_cmd_run_measured().
+typedef struct {
+  unsigned long cycles;
+  unsigned long bytes;
+} shell_cmd_probe_t;
+
+void shell_cmd_stats_begin(shell_cmd_probe_t *probe);
+
+/**
+ * @brief record a run of the top-level command `pCmdt` which started at `probe`.
+ *
+ * @return the cycles elapsed since `probe`.
+ */
+unsigned long shell_cmd_stats_end(const shell_cmd_t *pCmdt, const shell_cmd_probe_t *probe);
+
+/**
+ * @brief statistics of the top-level command `pCmdt`.
+ *
+ * @return NULL if `pCmdt` is not in the first CONFIG_SHELL_CMD_STATS entries of the command table.
+ */
+shell_cmd_stats_t *shell_cmd_stats(const shell_cmd_t *pCmdt);
+
+/**
+ * @brief run `fct(pCmdt, argc, argv)` (the top-level command `pCmdt`), and record it in the statistics.
+ *
+ * `time` itself is not recorded: the command it runs is.
+ *
+ * @return the return value of `fct`.
+ */
+int shell_cmd_run_measured(const shell_cmd_t *pCmdt, shell_cmd_cb_t fct, int argc, char *const argv[]);
+#else
+#define shell_cmd_run_measured(_pCmdt, _fct, _argc, _argv) (_fct)((_pCmdt), (_argc), (_argv))
+#endif /* CONFIG_SHELL_CMD_STATS > 0 */
+
 #endif /* __NANO_SHELL_COMMAND_H */
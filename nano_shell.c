@@ -14,12 +14,39 @@
 #include "shell_io/shell_io.h"
 #include "command/command.h"
 #include "readline/readline.h"
+#include "readline/history.h"
 #include "parse/text_parse.h"
+#include "readline/key_seq.h"
 
 #include "shell_config.h"
 
 #define NANO_SHELL_BUILD_VERDION "1.0"
 
+#if CONFIG_SHELL_MULTI_INSTANCE
+NANO_SHELL_CTX_TLS nano_shell_ctx_t *nano_shell_ctx;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+#if CONFIG_SHELL_CMD_TASK
+#if CONFIG_SHELL_MULTI_INSTANCE
+  #define nano_shell_task (nano_shell_ctx->task)
+  #define nano_shell_task_line (nano_shell_ctx->task_line)
+#else
+// the running resumable command.
+static shell_task_t nano_shell_task;
+// the line completed while the command is running, it is run after the command.
+static char *nano_shell_task_line;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+// a completed line is waiting for the running command, the input is left to the caller meanwhile.
+  #define nano_shell_input_blocked() (nano_shell_task_line != NULL)
+#else
+  #define nano_shell_input_blocked() 0
+#endif /* CONFIG_SHELL_CMD_TASK */
+
+#if CONFIG_SHELL_CMD_TASK || CONFIG_SHELL_CMD_WATCH
+#define SHELL_CTRL_C 0x03
+#endif /* CONFIG_SHELL_CMD_TASK || CONFIG_SHELL_CMD_WATCH */
+
 /**
  * @brief
  *
@@ -29,14 +56,18 @@
  */
 int nano_shell_run_cmd(int argc, char *const argv[])
 {
+#if CONFIG_SHELL_CMD_PATH_RESOLVE
+  return shell_resolve_and_run(argc, argv);
+#else
   const shell_cmd_t *pCmdt = shell_find_top_cmd(argv[0]);
 
   if (pCmdt) {
-    return pCmdt->cmd(pCmdt, argc, argv);
+    return shell_cmd_run_measured(pCmdt, pCmdt->cmd, argc, argv);
   }
   shell_printf("  %s: command not found.\r\n", argv[0]);
 
   return -1;
+#endif /* CONFIG_SHELL_CMD_PATH_RESOLVE */
 }
 
 
@@ -44,12 +75,37 @@ int nano_shell_run_cmd(int argc, char *const argv[])
 #error "CONFIG_SHELL_CMD_MAX_ARGC must be no less than 1."
 #endif
 
-void nano_shell_loop(void *argument)
+// parse the completed line and run it.
+static void nano_shell_exec_line(char *line)
 {
+#if CONFIG_SHELL_MULTI_INSTANCE
+  char **argv = nano_shell_ctx->argv;
+#else
   static char *argv[CONFIG_SHELL_CMD_MAX_ARGC + 1];
-  char *line;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
   int argc;
 
+  argc = nano_shell_parse_line(line, argv, CONFIG_SHELL_CMD_MAX_ARGC + 1);
+
+  if (argc > CONFIG_SHELL_CMD_MAX_ARGC) {
+    argc--;
+    shell_printf("** WARNING: too many args (max: %d)! ", CONFIG_SHELL_CMD_MAX_ARGC);
+    shell_printf("arguments after \"%s\" will be ignored. **\r\n", argv[argc - 1]);
+  }
+
+  if (argc > 0) {
+    nano_shell_run_cmd(argc, argv);
+  }
+}
+
+void nano_shell_loop(void *argument)
+{
+  char *line;
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+  nano_shell_ctx = argument;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
   shell_puts("\r\n"
              " _   _                     ____  _          _ _\r\n"
              "| \\ | | __ _ _ __   ___   / ___|| |__   ___| | |\r\n"
@@ -64,57 +120,272 @@ void nano_shell_loop(void *argument)
              " * Copyright: (c) Liber 2020\r\n"
              "\r\n");
 
+#if CONFIG_SHELL_CMD_TASK || CONFIG_SHELL_CMD_WATCH
+  // the input is handled as in react mode, so that the resumable commands and the `watch` jobs run
+  // between the characters.
+  (void)line;
+  if (CONFIG_SHELL_PROMPT) {
+    shell_puts(CONFIG_SHELL_PROMPT);
+  }
+
+  for (;;) {
+    char ch;
+
+    // while a line is waiting for the running command, the input stays in the port.
+    if (!nano_shell_input_blocked() && shell_getc(&ch)) {
+      nano_shell_react(ch);
+    } else if (!nano_shell_poll()) {  // the output has been flushed.
+#if CONFIG_SHELL_INPUT_WAIT
+      unsigned int timeout = CONFIG_SHELL_IDLE_PERIOD;
+#if CONFIG_SHELL_CMD_WATCH
+      if (shell_watch_next() < timeout) {  // wake up for the next job.
+        timeout = shell_watch_next();
+      }
+#endif /* CONFIG_SHELL_CMD_WATCH */
+      if (!shell_wait_input(timeout)) {
+        shell_idle();
+      }
+#endif /* CONFIG_SHELL_INPUT_WAIT */
+    }
+  }
+#else
   for (;;) {
     line = readline(CONFIG_SHELL_PROMPT);
 
-    argc = nano_shell_parse_line(line, argv, CONFIG_SHELL_CMD_MAX_ARGC + 1);
+    // shell_printf("[DEBUG] line: %s\r\n", line);
 
-    // shell_printf("[DEBUG] argc: %d\r\n", argc);
-    // for (int i = 0; i < argc; i++) {
-    //   shell_printf("[DEBUG] ARGV[%d]: %s\r\n", i, argv[i]);
-    // }
+    nano_shell_exec_line(line);
+  }
+#endif /* CONFIG_SHELL_CMD_TASK || CONFIG_SHELL_CMD_WATCH */
+}
 
-    if (argc > CONFIG_SHELL_CMD_MAX_ARGC) {
-      argc--;
-      shell_printf("** WARNING: too many args (max: %d)! ", CONFIG_SHELL_CMD_MAX_ARGC);
-      shell_printf("arguments after \"%s\" will be ignored. **\r\n", argv[argc - 1]);
-    }
 
-    if (argc > 0) {
-      nano_shell_run_cmd(argc, argv);
-    }
+// run the completed line, then display the prompt for the next one.
+static void nano_shell_line_done(char *line)
+{
+  /**
+   * in react mode, use if (* line) to avoid unnecessary process
+   * to improve speed.
+   */
+  if (*line) {
+    nano_shell_exec_line(line);
+  }
+
+#if CONFIG_SHELL_CMD_TASK
+  if (nano_shell_task.fn) {  // the prompt is displayed when the command is done.
+    return;
+  }
+#endif /* CONFIG_SHELL_CMD_TASK */
+
+  if (CONFIG_SHELL_PROMPT) {
+    shell_puts(CONFIG_SHELL_PROMPT);
   }
 }
 
 
-void nano_shell_react(char ch)
+#if CONFIG_SHELL_CMD_TASK
+int nano_shell_task_start(shell_task_cb_t fn, int argc, char *const argv[])
 {
-  static char *argv[CONFIG_SHELL_CMD_MAX_ARGC + 1];
-  int argc;
+  if (nano_shell_task.fn) {
+    shell_printf("  %s: another command is running.\r\n", argv[0]);
+    return -1;
+  }
+
+  memset(&nano_shell_task, 0, sizeof(nano_shell_task));
+  if (fn(&nano_shell_task, argc, argv) != NANO_SHELL_TASK_EXITED) {
+    nano_shell_task.fn = fn;
+  }
+
+  return 0;
+}
+
+
+// the running command is done: run the line typed meanwhile, or display the prompt and the typed text.
+static void nano_shell_task_done(void)
+{
+  char *line = nano_shell_task_line;
 
-  char *line = readline_react(ch);
+  nano_shell_task.fn = NULL;
+  nano_shell_task_line = NULL;
 
   if (line) {
-    /**
-     * in react mode, use if (* line) to avoid unnecessary process
-     * to improve speed.
-     */
-    if (*line) {
-      argc = nano_shell_parse_line(line, argv, CONFIG_SHELL_CMD_MAX_ARGC + 1);
-
-      if (argc > CONFIG_SHELL_CMD_MAX_ARGC) {
-        argc--;
-        shell_printf("** WARNING: too many args (max: %d)! ", CONFIG_SHELL_CMD_MAX_ARGC);
-        shell_printf("arguments after \"%s\" will be ignored. **\r\n", argv[argc - 1]);
+    nano_shell_line_done(line);
+  } else {
+    rl_redisplay();
+  }
+}
+
+
+// react to the input while a command is running, return 0 if `ch` is refused.
+static int nano_shell_task_input(char ch)
+{
+  char *line;
+
+  if (nano_shell_task_line && ch != SHELL_CTRL_C) {
+    return 0;  // a line is waiting for the command, the caller keeps the input.
+  }
+
+  line = readline_react(ch);
+
+  if (ch == SHELL_CTRL_C) {  // cancel the command: call it once more to clean up.
+    nano_shell_task.cancelled = 1;
+    nano_shell_task.fn(&nano_shell_task, 0, NULL);
+    nano_shell_task_line = line;
+    nano_shell_task_done();
+  } else if (line) {
+    nano_shell_task_line = line;
+  }
+  return 1;
+}
+
+
+#endif /* CONFIG_SHELL_CMD_TASK */
+
+
+#if NANO_SHELL_POLL
+int nano_shell_poll(void)
+{
+  int running = 0;
+
+#if CONFIG_SHELL_CMD_TASK
+  if (nano_shell_task.fn) {  // the `watch` jobs wait until the command is done.
+    if (nano_shell_task.fn(&nano_shell_task, 0, NULL) == NANO_SHELL_TASK_EXITED) {
+      nano_shell_task_done();
+    }
+    running = (nano_shell_task.fn != NULL);
+  } else
+#endif /* CONFIG_SHELL_CMD_TASK */
+  {
+#if CONFIG_SHELL_CMD_WATCH
+    shell_watch_run();
+#endif /* CONFIG_SHELL_CMD_WATCH */
+  }
+
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0 && CONFIG_SHELL_HIST_STORE
+  rl_history_poll();
+#endif /* CONFIG_SHELL_HIST_STORE */
+
+#if CONFIG_SHELL_TX_BUFFER_SIZE > 0
+  shell_flush();
+#endif /* CONFIG_SHELL_TX_BUFFER_SIZE > 0 */
+
+  return running;
+}
+#endif /* NANO_SHELL_POLL */
+
+
+int nano_shell_react(char ch)
+{
+  int used = 1;
+  char *line;
+
+#if CONFIG_SHELL_CMD_TASK
+  if (nano_shell_task.fn) {
+    used = nano_shell_task_input(ch);
+  } else
+#endif /* CONFIG_SHELL_CMD_TASK */
+#if CONFIG_SHELL_CMD_WATCH
+  if (ch == SHELL_CTRL_C && shell_watch_cancel()) {
+    // Ctrl-C stops the `watch` jobs, the input line is kept.
+  } else
+#endif /* CONFIG_SHELL_CMD_WATCH */
+  {
+    line = readline_react(ch);
+    if (line) {
+      nano_shell_line_done(line);
+    }
+  }
+
+#if CONFIG_SHELL_TX_BUFFER_SIZE > 0
+  shell_flush();
+#endif /* CONFIG_SHELL_TX_BUFFER_SIZE > 0 */
+
+  return used;
+}
+
+
+size_t nano_shell_react_buf(const char *buf, size_t len)
+{
+  size_t total = len, used, n;
+  char *line;
+
+  while (len > 0) {
+#if CONFIG_SHELL_CMD_TASK
+    if (nano_shell_task.fn) {
+      if (!nano_shell_task_input(*buf)) {
+        break;
       }
+      buf++;
+      len--;
+      continue;
+    }
+#endif /* CONFIG_SHELL_CMD_TASK */
+
+    n = len;
+#if CONFIG_SHELL_CMD_WATCH
+    if (shell_watch_next() != ~0U) {  // Ctrl-C stops the `watch` jobs, see `nano_shell_react()`.
+      const char *ctrl_c = memchr(buf, SHELL_CTRL_C, len);
 
-      if (argc > 0) {
-        nano_shell_run_cmd(argc, argv);
+      if (ctrl_c == buf) {
+        shell_watch_cancel();
+        buf++;
+        len--;
+        continue;
+      } else if (ctrl_c) {
+        n = (size_t)(ctrl_c - buf);
       }
     }
+#endif /* CONFIG_SHELL_CMD_WATCH */
+
+    line = readline_react_buf(buf, n, &used);
+    buf += used;
+    len -= used;
 
-    if (CONFIG_SHELL_PROMPT) {
-      shell_puts(CONFIG_SHELL_PROMPT);
+    if (line) {
+      nano_shell_line_done(line);
     }
   }
+
+#if CONFIG_SHELL_TX_BUFFER_SIZE > 0
+  shell_flush();
+#endif /* CONFIG_SHELL_TX_BUFFER_SIZE > 0 */
+
+  return total - len;
+}
+
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+void nano_shell_ctx_init(nano_shell_ctx_t *ctx, const nano_shell_io_t *io)
+{
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->io = io;
+
+  rl_ctx_init(&ctx->rl);
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0
+  rl_history_ctx_init(&ctx->hist);
+#endif /* CONFIG_SHELL_HIST_MIN_RECORD > 0 */
+}
+
+
+int nano_shell_react_ctx(nano_shell_ctx_t *ctx, char ch)
+{
+  nano_shell_ctx = ctx;
+  return nano_shell_react(ch);
+}
+
+
+size_t nano_shell_react_buf_ctx(nano_shell_ctx_t *ctx, const char *buf, size_t len)
+{
+  nano_shell_ctx = ctx;
+  return nano_shell_react_buf(buf, len);
+}
+
+
+#if NANO_SHELL_POLL
+int nano_shell_poll_ctx(nano_shell_ctx_t *ctx)
+{
+  nano_shell_ctx = ctx;
+  return nano_shell_poll();
 }
+#endif /* NANO_SHELL_POLL */
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
@@ -1,34 +1,129 @@
-/**
- * @file nano_shell.h
- * @author Liber (lvlebin@outlook.com)
- * @brief nano-shell interface. include this file in your project.
- * @version 1.0
- * @date 2020-03-27
- *
- * @copyright Copyright (c) Liber 2020
- *
- */
-
-
-#ifndef __NANO_SHELL_H
-#define __NANO_SHELL_H
-
-/**
- * @brief nano-shell infinite loop
- *
- * @param argument not used in ver1.0
- */
-void nano_shell_loop(void *argument);
-
-
-/**
- * @brief nano-shell non-block interface, just react to the input character.
- * It is non-blocked (unless there is an infinite loop in your command function)
- * you can call it when get a new character.
- *
- * @param ch input character
- */
-void nano_shell_react(char ch);
-
-
-#endif /*__NANO_SHELL_H */
+/**
+ * @file nano_shell.h
+ * @author Liber (lvlebin@outlook.com)
+ * @brief nano-shell interface. include this file in your project.
+ * @version 1.0
+ * @date 2020-03-27
+ *
+ * @copyright Copyright (c) Liber 2020
+ *
+ */
+
+
+#ifndef __NANO_SHELL_H
+#define __NANO_SHELL_H
+
+#include <stddef.h>
+
+#include "nano_shell_ctx.h"
+
+// `nano_shell_poll()` is needed by the resumable commands, the `watch` jobs and the persistent history.
+#define NANO_SHELL_POLL \
+  (CONFIG_SHELL_CMD_TASK || CONFIG_SHELL_CMD_WATCH || (CONFIG_SHELL_HIST_MIN_RECORD > 0 && CONFIG_SHELL_HIST_STORE))
+
+/**
+ * @brief nano-shell infinite loop
+ *
+ * @param argument the shell context (`nano_shell_ctx_t *`) if CONFIG_SHELL_MULTI_INSTANCE is enabled,
+ *                 otherwise not used.
+ */
+void nano_shell_loop(void *argument);
+
+
+/**
+ * @brief nano-shell non-block interface, just react to the input character.
+ * It is non-blocked (unless there is an infinite loop in your command function)
+ * you can call it when get a new character.
+ *
+ * @param ch input character
+ * @return int: 1 if `ch` is consumed. 0 if it is refused: a line typed while a resumable command
+ *              is running waits for the command (only Ctrl-C is accepted), keep `ch` and give it
+ *              again after `nano_shell_poll()`.
+ */
+int nano_shell_react(char ch);
+
+
+/**
+ * @brief nano-shell non-block interface, react to a block of input characters,
+ * e.g. a DMA transfer of pasted text. It has the same effect as calling `nano_shell_react()`
+ * for each character, but runs of printable characters are inserted and echoed at once.
+ * Every line completed in the block is run.
+ *
+ * @param buf input characters
+ * @param len the number of characters in `buf`
+ * @return size_t: the number of characters consumed, less than `len` if a character is refused
+ *                 (see `nano_shell_react()`), keep the rest and give it again after `nano_shell_poll()`.
+ */
+size_t nano_shell_react_buf(const char *buf, size_t len);
+
+
+#if NANO_SHELL_POLL
+/**
+ * @brief run the next step of the resumable command (NANO_SHELL_ADD_TASK_CMD()) if there is one,
+ * otherwise the `watch` jobs which are due, and write the pending history records to the storage
+ * CONFIG_SHELL_HIST_STORE_DELAY ms after the last one (CONFIG_SHELL_HIST_STORE).
+ * call it from your main loop (or a timer) in <interrupt mode>, `nano_shell_loop()` calls it itself.
+ *
+ * @return Result is non-zero if the command is still running, or 0 if no command is running.
+ */
+int nano_shell_poll(void);
+#endif /* NANO_SHELL_POLL */
+
+
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0 && CONFIG_SHELL_HIST_STORE
+/**
+ * @brief write the pending history records (CONFIG_SHELL_HIST_STORE_BATCH) to the storage at once.
+ * in <interrupt mode>, call it before reset or power down if `nano_shell_poll()` may not have written
+ * them yet, or instead of `nano_shell_poll()` when your main loop knows that the input is idle.
+ *
+ */
+void rl_history_flush(void);
+#endif /* CONFIG_SHELL_HIST_STORE */
+
+
+#if CONFIG_SHELL_TX_QUEUE_SIZE > 0
+/**
+ * @brief send the queued output (CONFIG_SHELL_TX_QUEUE_SIZE) through `low_level_write()` or
+ * `low_level_write_char()`. call it from your main loop, a timer or a low priority task if the queue
+ * is not drained by the transmit interrupt, see `shell_tx_start()` in "shell_io/shell_io.h".
+ *
+ */
+void nano_shell_flush(void);
+#endif /* CONFIG_SHELL_TX_QUEUE_SIZE > 0 */
+
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+/**
+ * @brief initialize a shell context, every console has its own context.
+ *
+ * @param ctx the context to be initialized.
+ * @param io I/O functions of the console, MUST be valid as long as the context is used.
+ */
+void nano_shell_ctx_init(nano_shell_ctx_t *ctx, const nano_shell_io_t *io);
+
+
+/**
+ * @brief `nano_shell_react()` for the console of `ctx`.
+ *
+ */
+int nano_shell_react_ctx(nano_shell_ctx_t *ctx, char ch);
+
+
+/**
+ * @brief `nano_shell_react_buf()` for the console of `ctx`.
+ *
+ */
+size_t nano_shell_react_buf_ctx(nano_shell_ctx_t *ctx, const char *buf, size_t len);
+
+
+#if NANO_SHELL_POLL
+/**
+ * @brief `nano_shell_poll()` for the console of `ctx`.
+ *
+ */
+int nano_shell_poll_ctx(nano_shell_ctx_t *ctx);
+#endif /* NANO_SHELL_POLL */
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+
+#endif /*__NANO_SHELL_H */
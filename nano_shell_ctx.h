@@ -0,0 +1,102 @@
+/**
+ * @file nano_shell_ctx.h
+ * @author Liber (lvlebin@outlook.com)
+ * @brief shell context, one for every console served by nano-shell.
+ * @version 1.0
+ * @date 2020-03-27
+ *
+ * @copyright Copyright (c) Liber 2020
+ *
+ */
+
+#ifndef __NANO_SHELL_CTX_H
+#define __NANO_SHELL_CTX_H
+
+#include "shell_config.h"
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+
+#include <stddef.h>
+
+#include "readline/readline.h"
+#include "readline/history.h"
+#include "readline/key_seq.h"
+#include "command/command.h"
+
+
+/**
+ * @brief I/O functions of a console.
+ *
+ * @write_char: send a character, the same as `low_level_write_char()` of the single instance build.
+ * @read_char: the same as `shell_getc()` of the single instance build, used only by `nano_shell_loop()`,
+ *             can be NULL in react mode.
+ * @wait_input: the same as `shell_wait_input()` (if CONFIG_SHELL_INPUT_WAIT is enabled), can be NULL.
+ * @write: the same as `low_level_write()` (if CONFIG_SHELL_LOW_LEVEL_WRITE is enabled), can be NULL,
+ *         then `write_char` is used.
+ */
+typedef struct {
+  void (*write_char)(char ch);
+  int (*read_char)(char *ch);
+#if CONFIG_SHELL_INPUT_WAIT
+  int (*wait_input)(unsigned int timeout);
+#endif /* CONFIG_SHELL_INPUT_WAIT */
+#if CONFIG_SHELL_LOW_LEVEL_WRITE
+  void (*write)(const char *buf, size_t len);
+#endif /* CONFIG_SHELL_LOW_LEVEL_WRITE */
+} nano_shell_io_t;
+
+
+/**
+ * @brief everything nano-shell keeps for one console.
+ *        initialize it with `nano_shell_ctx_init()`, don't access the fields directly.
+ */
+typedef struct nano_shell_ctx {
+  const nano_shell_io_t *io;
+
+  rl_ctx_t rl;
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0
+  rl_history_ctx_t hist;
+#endif /* CONFIG_SHELL_HIST_MIN_RECORD > 0 */
+#if CONFIG_SHELL_KEY_SEQ_BIND
+  key_seq_ctx_t key_seq;
+#endif /* CONFIG_SHELL_KEY_SEQ_BIND */
+
+  char *argv[CONFIG_SHELL_CMD_MAX_ARGC + 1];
+#if !CONFIG_SHELL_PRINTF_BUILTIN
+  char printf_buffer[CONFIG_SHELL_PRINTF_BUFFER_SIZE];
+#endif /* !CONFIG_SHELL_PRINTF_BUILTIN */
+#if CONFIG_SHELL_TX_BUFFER_SIZE > 0
+  char tx_buffer[CONFIG_SHELL_TX_BUFFER_SIZE];
+  size_t tx_len;
+#endif /* CONFIG_SHELL_TX_BUFFER_SIZE > 0 */
+#if CONFIG_SHELL_CMD_STATS > 0
+  unsigned long tx_count;
+#endif /* CONFIG_SHELL_CMD_STATS > 0 */
+#if CONFIG_SHELL_CMD_TASK
+  shell_task_t task;
+  char *task_line;
+#endif /* CONFIG_SHELL_CMD_TASK */
+#if CONFIG_SHELL_CMD_WATCH
+  shell_watch_job_t watch_jobs[CONFIG_SHELL_WATCH_JOBS];
+#endif /* CONFIG_SHELL_CMD_WATCH */
+} nano_shell_ctx_t;
+
+
+/**
+ * storage class of `nano_shell_ctx`. if the contexts are served by different threads (such as
+ * `nano_shell_loop()` in several tasks), define it as the thread-local storage class of your
+ * compiler, for example: `#define NANO_SHELL_CTX_TLS __thread`
+ */
+#ifndef NANO_SHELL_CTX_TLS
+#define NANO_SHELL_CTX_TLS
+#endif
+
+/**
+ * @brief the current context, set by `nano_shell_loop()`, `nano_shell_react_ctx()`, etc.
+ *        the commands print to the console of the current context.
+ */
+extern NANO_SHELL_CTX_TLS nano_shell_ctx_t *nano_shell_ctx;
+
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+#endif /* __NANO_SHELL_CTX_H */
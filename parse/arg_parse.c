@@ -0,0 +1,258 @@
+/**
+ * @file arg_parse.c
+ * @author Liber (lvlebin@outlook.com)
+ * @brief the shared argument parser, see @file{arg_parse.h}
+ * @version 1.0
+ * @date 2020-04-05
+ *
+ * @copyright Copyright (c) Liber 2020
+ *
+ */
+
+#include <string.h>
+
+#include "arg_parse.h"
+#include "text_parse.h"
+#include "shell_io/shell_io.h"
+
+#include "shell_config.h"
+
+#if CONFIG_SHELL_CMD_ARG_SPEC
+
+#define IS_OPTION(spec) ((spec)->flags & SHELL_ARG_F_OPTION)
+
+#define ARG_FIELD(out, spec, type) ((type *)((char *)(out) + (spec)->offset))
+
+
+// find the next positional argument specification from `spec`.
+static const shell_arg_spec_t *next_positional(const shell_arg_spec_t *spec)
+{
+  while (spec->type != SHELL_ARG_END && IS_OPTION(spec)) {
+    spec++;
+  }
+  return spec->type == SHELL_ARG_END ? NULL : spec;
+}
+
+static const shell_arg_spec_t *find_short_option(const shell_arg_spec_t *spec, char ch)
+{
+  for (; spec->type != SHELL_ARG_END; spec++) {
+    if (IS_OPTION(spec) && spec->short_name == ch) {
+      return spec;
+    }
+  }
+  return NULL;
+}
+
+static const shell_arg_spec_t *find_long_option(const shell_arg_spec_t *spec, const char *name, size_t len)
+{
+  for (; spec->type != SHELL_ARG_END; spec++) {
+    if (IS_OPTION(spec) && spec->name && strncmp(spec->name, name, len) == 0 && spec->name[len] == '\0') {
+      return spec;
+    }
+  }
+  return NULL;
+}
+
+// convert `value` and store it in the field, return 0 if `value` is invalid.
+static int store_arg(const shell_arg_spec_t *spec, const char *value, void *out)
+{
+  long num;
+
+  switch (spec->type) {
+    case SHELL_ARG_INT:
+      if (!nano_shell_parse_num(value, &num)) {
+        return 0;
+      }
+      *ARG_FIELD(out, spec, long) = num;
+      return 1;
+
+    case SHELL_ARG_UINT:
+      if (*value == '-' || !nano_shell_parse_num(value, &num)) {
+        return 0;
+      }
+      *ARG_FIELD(out, spec, unsigned long) = (unsigned long)num;
+      return 1;
+
+    case SHELL_ARG_HEX:
+      return nano_shell_parse_hex(value, ARG_FIELD(out, spec, unsigned long));
+
+    case SHELL_ARG_STR:
+      *ARG_FIELD(out, spec, const char *) = value;
+      return 1;
+
+    case SHELL_ARG_ENUM:
+      for (int i = 0; spec->choices[i]; i++) {
+        if (strcmp(spec->choices[i], value) == 0) {
+          *ARG_FIELD(out, spec, int) = i;
+          return 1;
+        }
+      }
+      return 0;
+
+    default:
+      return 0;
+  }
+}
+
+static const char *type_hint(const shell_arg_spec_t *spec)
+{
+  static const char *const hints[] = {"", "int", "uint", "hex", "str", "", ""};
+  return hints[spec->type];
+}
+
+static void print_choices(const shell_arg_spec_t *spec)
+{
+  for (int i = 0; spec->choices[i]; i++) {
+    shell_printf(i ? "|%s" : "%s", spec->choices[i]);
+  }
+}
+
+// print an option as `-x|--name`
+static void print_option_name(const shell_arg_spec_t *spec)
+{
+  if (spec->short_name) {
+    shell_printf(spec->name ? "-%c|" : "-%c", spec->short_name);
+  }
+  if (spec->name) {
+    shell_printf("--%s", spec->name);
+  }
+}
+
+// print an option or argument as it is shown in usage, such as `-w|--width=<uint>` or `<addr>`
+static void print_arg_usage(const shell_arg_spec_t *spec)
+{
+  if (IS_OPTION(spec)) {
+    print_option_name(spec);
+    if (spec->type == SHELL_ARG_FLAG) {
+      return;
+    }
+    shell_puts(spec->name ? "=" : " ");
+  }
+
+  if (spec->type == SHELL_ARG_ENUM) {
+    shell_putc('{');
+    print_choices(spec);
+    shell_putc('}');
+  } else if (IS_OPTION(spec)) {
+    shell_printf("<%s>", type_hint(spec));
+  } else {
+    shell_printf("<%s>", spec->name);
+  }
+}
+
+void shell_print_args_usage(const char *name, const shell_arg_spec_t *spec)
+{
+  shell_printf("  Usage: %s", name);
+  for (; spec->type != SHELL_ARG_END; spec++) {
+    int optional = IS_OPTION(spec) || (spec->flags & SHELL_ARG_F_OPTIONAL);
+    shell_puts(optional ? " [" : " ");
+    print_arg_usage(spec);
+    if (optional) {
+      shell_putc(']');
+    }
+  }
+  shell_puts("\r\n");
+}
+
+void shell_print_args_help(const char *name, const shell_arg_spec_t *spec)
+{
+  shell_print_args_usage(name, spec);
+  shell_puts("\r\n");
+  for (; spec->type != SHELL_ARG_END; spec++) {
+    shell_puts("    ");
+    print_arg_usage(spec);
+    shell_printf(": %s\r\n", spec->help ? spec->help : "");
+  }
+}
+
+static int arg_error(const char *name, const shell_arg_spec_t *spec, const char *msg, const char *arg)
+{
+  shell_printf("  %s: %s '%s'.\r\n", name, msg, arg);
+  shell_print_args_usage(name, spec);
+  return -1;
+}
+
+int shell_parse_args(const shell_arg_spec_t *spec, int argc, char *const argv[], void *out)
+{
+  const shell_arg_spec_t *pos = next_positional(spec);
+  const shell_arg_spec_t *opt;
+  const char *value;
+  int only_positional = 0;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+
+    /**
+     * `-` alone and negative numbers (unless there is a digit option) are positional.
+     */
+    if (only_positional || arg[0] != '-' || arg[1] == '\0' ||
+        (arg[1] >= '0' && arg[1] <= '9' && !find_short_option(spec, arg[1]))) {
+      if (pos == NULL) {
+        return arg_error(argv[0], spec, "too many arguments", arg);
+      }
+      if (!store_arg(pos, arg, out)) {
+        return arg_error(argv[0], spec, "invalid value", arg);
+      }
+      pos = next_positional(pos + 1);
+      continue;
+    }
+
+    if (arg[1] == '-') {  // `--`, `--name`, `--name=value` or `--name value`
+      const char *name = arg + 2;
+      const char *eq = strchr(name, '=');
+
+      if (*name == '\0') {
+        only_positional = 1;
+        continue;
+      }
+
+      opt = find_long_option(spec, name, eq ? (size_t)(eq - name) : strlen(name));
+      if (opt == NULL) {
+        return arg_error(argv[0], spec, "unknown option", arg);
+      }
+
+      if (opt->type == SHELL_ARG_FLAG) {
+        if (eq) {
+          return arg_error(argv[0], spec, "option takes no value", arg);
+        }
+        *ARG_FIELD(out, opt, int) = 1;
+        continue;
+      }
+      value = eq ? eq + 1 : (i + 1 < argc ? argv[++i] : NULL);
+    } else {  // `-x`, `-xyz` (flags), `-x value` or `-xvalue`
+      value = NULL;
+      for (const char *p = arg + 1; *p; p++) {
+        opt = find_short_option(spec, *p);
+        if (opt == NULL) {
+          return arg_error(argv[0], spec, "unknown option", arg);
+        }
+        if (opt->type == SHELL_ARG_FLAG) {
+          *ARG_FIELD(out, opt, int) = 1;
+          continue;
+        }
+        value = p[1] ? p + 1 : (i + 1 < argc ? argv[++i] : NULL);
+        break;
+      }
+      if (opt->type == SHELL_ARG_FLAG) {
+        continue;
+      }
+    }
+
+    if (value == NULL) {
+      return arg_error(argv[0], spec, "missing value of", arg);
+    }
+    if (!store_arg(opt, value, out)) {
+      return arg_error(argv[0], spec, "invalid value", value);
+    }
+  }
+
+  for (; pos; pos = next_positional(pos + 1)) {
+    if (!(pos->flags & SHELL_ARG_F_OPTIONAL)) {
+      return arg_error(argv[0], spec, "missing argument", pos->name);
+    }
+  }
+
+  return 0;
+}
+
+#endif /* CONFIG_SHELL_CMD_ARG_SPEC */
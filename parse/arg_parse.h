@@ -0,0 +1,136 @@
+/**
+ * @file arg_parse.h
+ * @author Liber (lvlebin@outlook.com)
+ * @brief declarative argument specification and the shared argument parser.
+ * @version 1.0
+ * @date 2020-04-05
+ *
+ * @copyright Copyright (c) Liber 2020
+ *
+ */
+
+#ifndef __NANO_SHELL_ARG_PARSE_H
+#define __NANO_SHELL_ARG_PARSE_H
+
+#include <stddef.h>
+
+/**
+ * type of the argument, and the type of the field that receives it:
+ *
+ * SHELL_ARG_INT:  decimal or hexadecimal(0x) number, may be negative.  field: long
+ * SHELL_ARG_UINT: decimal or hexadecimal(0x) number.                   field: unsigned long
+ * SHELL_ARG_HEX:  hexadecimal number, with or without `0x`.            field: unsigned long
+ * SHELL_ARG_STR:  any string.                                          field: const char *
+ * SHELL_ARG_ENUM: one of the strings in `choices`.                     field: int (index in `choices`)
+ * SHELL_ARG_FLAG: option without value, such as `-v`.                  field: int (set to 1 if present)
+ */
+enum {
+  SHELL_ARG_END = 0,
+  SHELL_ARG_INT,
+  SHELL_ARG_UINT,
+  SHELL_ARG_HEX,
+  SHELL_ARG_STR,
+  SHELL_ARG_ENUM,
+  SHELL_ARG_FLAG,
+};
+
+#define SHELL_ARG_F_OPTION   0x01  // named option (`-x value`, `--name=value`), else positional
+#define SHELL_ARG_F_OPTIONAL 0x02  // positional argument that can be omitted
+
+// argument specification, an array of them is terminated by @ref SHELL_ARG_END_ENTRY
+typedef struct {
+  const char *name;  // positional: name shown in usage. option: long name (`--name`), can be NULL.
+
+  const char *const *choices;  // SHELL_ARG_ENUM: NULL-terminated list of strings.
+
+  const char *help;  // help information of the argument.
+
+  unsigned short offset;  // offset of the field in the struct filled by @ref shell_parse_args()
+
+  char short_name;  // option: short name (`-x`), 0 if none.
+
+  unsigned char type;  // SHELL_ARG_XXX
+
+  unsigned char flags;  // SHELL_ARG_F_XXX
+} shell_arg_spec_t;
+
+
+#define _shell_arg_entry(_name, _short, _type, _flags, _struct, _field, _choices, _help) \
+  { _name, _choices, _help, (unsigned short)offsetof(_struct, _field), _short, _type, _flags }
+
+/**
+ * @brief positional argument, the name shown in usage is the name of the field.
+ *
+ * @_type: SHELL_ARG_INT, SHELL_ARG_UINT, SHELL_ARG_HEX or SHELL_ARG_STR.
+ * @_struct: type of the struct filled by @ref shell_parse_args().
+ * @_field: field of @c _struct. Note: THIS IS NOT a string.
+ * @_help: help information. This is a string.
+ */
+#define SHELL_ARG_POS(_type, _struct, _field, _help) \
+  _shell_arg_entry(#_field, 0, _type, 0, _struct, _field, NULL, _help)
+
+// same as @ref SHELL_ARG_POS(), but the argument can be omitted (the field is left untouched).
+#define SHELL_ARG_POS_OPTIONAL(_type, _struct, _field, _help) \
+  _shell_arg_entry(#_field, 0, _type, SHELL_ARG_F_OPTIONAL, _struct, _field, NULL, _help)
+
+// positional argument which is one of @c _choices (NULL-terminated array of strings).
+#define SHELL_ARG_POS_ENUM(_struct, _field, _choices, _help) \
+  _shell_arg_entry(#_field, 0, SHELL_ARG_ENUM, 0, _struct, _field, _choices, _help)
+
+/**
+ * @brief named option with a value: `-x value`, `-xvalue`, `--name=value` or `--name value`.
+ *
+ * @_short: short name, such as 'x'. 0 if none.
+ * @_long: long name, such as "name". NULL if none.
+ * @_type: SHELL_ARG_INT, SHELL_ARG_UINT, SHELL_ARG_HEX or SHELL_ARG_STR.
+ */
+#define SHELL_ARG_OPTION(_short, _long, _type, _struct, _field, _help) \
+  _shell_arg_entry(_long, _short, _type, SHELL_ARG_F_OPTION, _struct, _field, NULL, _help)
+
+// named option which is one of @c _choices (NULL-terminated array of strings).
+#define SHELL_ARG_OPTION_ENUM(_short, _long, _struct, _field, _choices, _help) \
+  _shell_arg_entry(_long, _short, SHELL_ARG_ENUM, SHELL_ARG_F_OPTION, _struct, _field, _choices, _help)
+
+// named option without value: `-x` or `--name`. short flags can be grouped: `-xyz`.
+#define SHELL_ARG_FLAG(_short, _long, _struct, _field, _help) \
+  _shell_arg_entry(_long, _short, SHELL_ARG_FLAG, SHELL_ARG_F_OPTION, _struct, _field, NULL, _help)
+
+// the last entry of an array of argument specifications.
+#define SHELL_ARG_END_ENTRY { NULL, NULL, NULL, 0, 0, SHELL_ARG_END, 0 }
+
+
+/**
+ * @brief parse the arguments according to the specifications, and fill the struct @c out.
+ *        print the error and usage if the arguments are invalid.
+ *
+ * `--` ends the options, the arguments after it are all positional.
+ *
+ * @param spec: array of argument specifications, terminated by @ref SHELL_ARG_END_ENTRY.
+ * @param argc: the count of arguments.
+ * @param argv: argument vector, argv[0] is the command name.
+ * @param out: the struct to be filled. fields of omitted arguments are left untouched,
+ *             so initialize it with the default values.
+ * @return int: 0 if succeed, else -1.
+ */
+int shell_parse_args(const shell_arg_spec_t *spec, int argc, char *const argv[], void *out);
+
+
+/**
+ * @brief print usage of a command, such as `Usage: dump [-v] [-w|--width=<uint>] <addr> [count]`
+ *
+ * @param name: name of the command.
+ * @param spec: array of argument specifications.
+ */
+void shell_print_args_usage(const char *name, const shell_arg_spec_t *spec);
+
+
+/**
+ * @brief print usage and the help information of each argument.
+ *
+ * @param name: name of the command.
+ * @param spec: array of argument specifications.
+ */
+void shell_print_args_help(const char *name, const shell_arg_spec_t *spec);
+
+
+#endif /* __NANO_SHELL_ARG_PARSE_H */
@@ -10,7 +10,10 @@
  */
 
 
+#include <limits.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include "text_parse.h"
 
 #define isblank(c) ((c) == ' ' || (c) == '\t')
@@ -52,3 +55,297 @@ int nano_shell_parse_line(char *input, char *argv[], const int maxArgc)
 
   return nargc;
 }
+
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+/**
+ * word-at-a-time scan: test sizeof(size_t) characters at once.
+ * WORD_HAS_BYTE() sets the high bit of each byte of `w` which equals to `ch`.
+ * The lowest flagged byte is the first match (little endian), the others may be false positives.
+ */
+#define WORD_ONES ((size_t)-1 / 0xFF)
+#define WORD_HIGHS (WORD_ONES * 0x80)
+#define WORD_HAS_ZERO(w) (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+#define WORD_HAS_BYTE(w, ch) WORD_HAS_ZERO((w) ^ (WORD_ONES * (unsigned char)(ch)))
+
+static inline size_t word_load(const char *str)
+{
+  size_t word;
+  memcpy(&word, str, sizeof(word));
+  return word;
+}
+
+static inline size_t word_first(size_t mask)
+{
+  return (sizeof(size_t) > sizeof(unsigned int) ? __builtin_ctzll(mask) : __builtin_ctz(mask)) >> 3;
+}
+#endif /* __GNUC__ && __ORDER_LITTLE_ENDIAN__ */
+
+
+// return the position of the first blank or '\0' in [pos, len), or len if none.
+static size_t scan_word_end(const char *line, size_t pos, size_t len)
+{
+#ifdef WORD_ONES
+  for (; pos + sizeof(size_t) <= len; pos += sizeof(size_t)) {
+    size_t word = word_load(line + pos);
+    size_t mask = WORD_HAS_BYTE(word, ' ') | WORD_HAS_BYTE(word, '\t') | WORD_HAS_ZERO(word);
+    if (mask) {
+      return pos + word_first(mask);
+    }
+  }
+#endif /* WORD_ONES */
+
+  while (pos < len && line[pos] && !isblank(line[pos])) {
+    pos++;
+  }
+  return pos;
+}
+
+// return the position of the first `quote`, backslash or '\0' in [pos, len), or len if none.
+static size_t scan_quote_end(const char *line, size_t pos, size_t len, char quote)
+{
+#ifdef WORD_ONES
+  for (; pos + sizeof(size_t) <= len; pos += sizeof(size_t)) {
+    size_t word = word_load(line + pos);
+    size_t mask = WORD_HAS_BYTE(word, quote) | WORD_HAS_BYTE(word, '\\') | WORD_HAS_ZERO(word);
+    if (mask) {
+      return pos + word_first(mask);
+    }
+  }
+#endif /* WORD_ONES */
+
+  while (pos < len && line[pos] && line[pos] != quote && line[pos] != '\\') {
+    pos++;
+  }
+  return pos;
+}
+
+// characters that can be escaped by backslash in quotes.
+#define IS_ESCAPABLE(ch) ((ch) == '"' || (ch) == '\'' || (ch) == '\\')
+
+
+int nano_shell_tokenize(const char *line, size_t len, shell_span_t spans[], const int maxSpans)
+{
+  size_t pos = 0;
+  int nspan = 0;
+
+  while (nspan < maxSpans) {
+    while (pos < len && isblank(line[pos])) {
+      pos++;
+    }
+    if (pos >= len || line[pos] == '\0') {  // end of input
+      break;
+    }
+
+    spans[nspan].flags = 0;
+
+    if (line[pos] == '\'' || line[pos] == '"') {  // single quotes ('') and double quotes ("")
+      char quote = line[pos++];
+      size_t start = pos;
+
+      spans[nspan].flags = SHELL_SPAN_QUOTED;
+      for (;;) {
+        pos = scan_quote_end(line, pos, len, quote);
+        if (pos + 1 < len && line[pos] == '\\' && IS_ESCAPABLE(line[pos + 1])) {
+          spans[nspan].flags |= SHELL_SPAN_ESCAPED;
+          pos += 2;
+        } else if (pos < len && line[pos] == '\\') {
+          pos++;
+        } else {
+          break;
+        }
+      }
+      spans[nspan].ptr = &line[start];
+      spans[nspan].len = pos - start;
+      if (pos < len && line[pos] == quote) {  // skip the closing quote, an unclosed one ends at '\0'
+        pos++;
+      }
+    } else {  // normal character
+      size_t start = pos;
+      pos = scan_word_end(line, pos, len);
+      spans[nspan].ptr = &line[start];
+      spans[nspan].len = pos - start;
+    }
+    nspan++;
+  }
+
+  return nspan;
+}
+
+
+size_t nano_shell_span_copy(const shell_span_t *span, char *dst, size_t size)
+{
+  size_t n = 0;
+
+  if (size == 0) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < span->len && n + 1 < size; i++) {
+    char ch = span->ptr[i];
+    if ((span->flags & SHELL_SPAN_ESCAPED) && ch == '\\' && i + 1 < span->len &&
+        IS_ESCAPABLE(span->ptr[i + 1])) {
+      ch = span->ptr[++i];
+    }
+    dst[n++] = ch;
+  }
+  dst[n] = '\0';
+  return n;
+}
+
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+/**
+ * SWAR (SIMD Within A Register) conversion: 8 characters are checked and converted at once
+ * with 64-bit arithmetic. The first character is in the lowest byte (little endian).
+ */
+#define SWAR_ONES (0x0101010101010101ULL)
+#define SWAR_HIGHS (0x8080808080808080ULL)
+
+// non-zero high bit in each byte `b` of `x` (b < 0x80) that m < b < n.
+#define SWAR_BETWEEN(x, m, n) \
+  (((SWAR_ONES * (127 + (n)) - ((x) & SWAR_ONES * 127)) & ~(x) & (((x) & SWAR_ONES * 127) + SWAR_ONES * (127 - (m)))) & SWAR_HIGHS)
+
+static inline uint64_t swar_load(const char *str)
+{
+  uint64_t chunk;
+  memcpy(&chunk, str, sizeof(chunk));
+  return chunk;
+}
+
+// convert 8 decimal digits, return 0 if any of them is not a digit.
+static inline int swar_parse_dec8(const char *str, uint32_t *value)
+{
+  uint64_t chunk = swar_load(str);
+
+  if ((((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+        (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) != 0x3333333333333333ULL)) {
+    return 0;
+  }
+
+  chunk -= 0x3030303030303030ULL;
+  chunk = (chunk * 10) + (chunk >> 8);  // 2 digits in each 16-bit lane
+  chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+           (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+  *value = (uint32_t)chunk;
+  return 1;
+}
+
+// convert 8 hexadecimal digits, return 0 if any of them is not a hexadecimal digit.
+static inline int swar_parse_hex8(const char *str, uint32_t *value)
+{
+  uint64_t chunk = swar_load(str);
+  uint64_t lower = chunk | (SWAR_ONES * 0x20);
+  uint64_t digit = SWAR_BETWEEN(chunk, '0' - 1, '9' + 1);
+  uint64_t alpha = SWAR_BETWEEN(lower, 'a' - 1, 'f' + 1);
+
+  if ((chunk & SWAR_HIGHS) || (digit | alpha) != SWAR_HIGHS) {
+    return 0;
+  }
+
+  chunk = (chunk & (SWAR_ONES * 0x0F)) + (alpha >> 7) * 9;  // one nibble in each byte
+  chunk = ((chunk & 0x0F000F000F000F00ULL) >> 8) | ((chunk & 0x000F000F000F000FULL) << 4);
+  chunk = ((chunk & 0x00FF000000FF0000ULL) >> 16) | ((chunk & 0x000000FF000000FFULL) << 8);
+  *value = (uint32_t)(((chunk & 0xFFFF) << 16) | ((chunk >> 32) & 0xFFFF));
+  return 1;
+}
+#endif /* __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ */
+
+
+static int parse_dec(const char *str, size_t len, unsigned long *value)
+{
+  unsigned long result = 0;
+
+  if (len == 0) {
+    return 0;
+  }
+
+#ifdef SWAR_ONES
+  for (; len >= 8; len -= 8, str += 8) {
+    uint32_t tmp;
+    if (!swar_parse_dec8(str, &tmp) || result > (ULONG_MAX - tmp) / 100000000UL) {
+      return 0;
+    }
+    result = result * 100000000UL + tmp;
+  }
+#endif /* SWAR_ONES */
+
+  for (; len; len--, str++) {
+    if (*str < '0' || *str > '9' || result > (ULONG_MAX - (unsigned long)(*str - '0')) / 10) {
+      return 0;
+    }
+    result = result * 10 + (*str - '0');
+  }
+
+  *value = result;
+  return 1;
+}
+
+static int parse_hex(const char *str, size_t len, unsigned long *value)
+{
+  unsigned long result = 0;
+
+  if (len == 0) {
+    return 0;
+  }
+
+#ifdef SWAR_ONES
+  for (; len >= 8; len -= 8, str += 8) {
+    uint32_t tmp;
+    if (!swar_parse_hex8(str, &tmp) || result > ((ULONG_MAX >> 16) >> 16)) {
+      return 0;
+    }
+    result = (unsigned long)(((unsigned long long)result << 16) << 16) | tmp;
+  }
+#endif /* SWAR_ONES */
+
+  for (; len; len--, str++) {
+    unsigned char ch = *str;
+    if (ch >= '0' && ch <= '9') {
+      ch -= '0';
+    } else if ((ch | 0x20) >= 'a' && (ch | 0x20) <= 'f') {
+      ch = (ch | 0x20) - 'a' + 10;
+    } else {
+      return 0;
+    }
+    if (result > (ULONG_MAX >> 4)) {
+      return 0;
+    }
+    result = (result << 4) | ch;
+  }
+
+  *value = result;
+  return 1;
+}
+
+
+int nano_shell_parse_num(const char *str, long *value)
+{
+  unsigned long result;
+  int negative = 0;
+
+  if (*str == '-') {
+    negative = 1;
+    str++;
+  }
+
+  if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+    if (!parse_hex(str + 2, strlen(str + 2), &result)) {
+      return 0;
+    }
+  } else if (!parse_dec(str, strlen(str), &result) || result > (unsigned long)LONG_MAX + negative) {
+    return 0;
+  }
+
+  *value = negative ? (long)(0UL - result) : (long)result;
+  return 1;
+}
+
+
+int nano_shell_parse_hex(const char *str, unsigned long *value)
+{
+  if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+    str += 2;
+  }
+  return parse_hex(str, strlen(str), value);
+}
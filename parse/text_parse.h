@@ -13,8 +13,11 @@
 #ifndef __NANO_SHELL_TEXT_PARSE_H
 #define __NANO_SHELL_TEXT_PARSE_H
 
+#include <stddef.h>
+
 /**
  * @brief parse the line, doesn't support backslash('\') in ver1.0
+ *        the line is split destructively, see nano_shell_tokenize() for a non-destructive one.
  *
  * @param input: the line to be parsed.
  * @param argv:
@@ -24,4 +27,65 @@
 int nano_shell_parse_line(char *input, char *argv[], const int maxArgc);
 
 
+// a token of the line: `len` characters from `ptr`, NOT terminated by '\0'.
+typedef struct {
+  const char *ptr;
+  size_t len;
+  unsigned char flags;  // SHELL_SPAN_XXX
+} shell_span_t;
+
+#define SHELL_SPAN_QUOTED  0x01  // the token was quoted, `ptr` points to the character after the quote.
+#define SHELL_SPAN_ESCAPED 0x02  // the token contains escapes, use nano_shell_span_copy() to get the text.
+
+
+/**
+ * @brief split the line into tokens without modifying it.
+ *
+ * Tokens are separated by blanks (' ' and '\t'), and can be quoted by '' or "".
+ * In quotes, a backslash('\') escapes the next character if it is a quote or a backslash,
+ * such as "say \"hi\"", otherwise the backslash is a normal character.
+ *
+ * @param line: the line to be parsed, it is not modified.
+ * @param len: length of the line, parsing also stops at '\0'.
+ * @param spans: return the tokens.
+ * @param maxSpans: max number of tokens.
+ * @return int: the number of tokens.
+ */
+int nano_shell_tokenize(const char *line, size_t len, shell_span_t spans[], const int maxSpans);
+
+
+/**
+ * @brief copy the text of a token to `dst`, with escapes resolved and terminated by '\0'.
+ *
+ * @param span: the token.
+ * @param dst: destination buffer.
+ * @param size: size of `dst`, the text is truncated if it is too long.
+ * @return size_t: the number of characters copied (without the terminating '\0').
+ */
+size_t nano_shell_span_copy(const shell_span_t *span, char *dst, size_t size);
+
+
+/**
+ * @brief convert a decimal (such as "123", "-45") or hexadecimal ("0x1F") string to number.
+ *
+ * decimal numbers must fit in a long, hexadecimal numbers in an unsigned long (their bits are
+ *   returned as is, "0xFFFFFFFF" is -1 with a 32-bit long).
+ *
+ * @param str: the string to be converted.
+ * @param value: return the number if `str` is a valid number.
+ * @return int: 1 if `str` is a valid number (and doesn't overflow), else 0.
+ */
+int nano_shell_parse_num(const char *str, long *value);
+
+
+/**
+ * @brief convert a hexadecimal string, with or without `0x` (such as "1F", "0x1f") to number.
+ *
+ * @param str: the string to be converted.
+ * @param value: return the number if `str` is a valid hexadecimal number.
+ * @return int: 1 if `str` is a valid hexadecimal number, else 0.
+ */
+int nano_shell_parse_hex(const char *str, unsigned long *value);
+
+
 #endif /* __NANO_SHELL_TEXT_PARSE_H */
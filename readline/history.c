@@ -9,107 +9,897 @@
  *
  */
 
+#include <stdint.h>
 #include <string.h>
 
 #include "history.h"
+#include "shell_io/shell_io.h"
 #include "shell_config.h"
 
 #if CONFIG_SHELL_HIST_MIN_RECORD > 0
 
-typedef unsigned char len_t;
-
 /**
-memory view of the history buffer:
+memory view of the history buffer (ring buffer):
 
 -------------------------------------------------------------------------------------------
-|length| string |length| *** |length| string |length|                                     |
-|<---- 1st record ---->| *** |<----   record   ---->|                                     |
-^                            ^                      ^                                     ^
-&buffer[0]                   cursor                 tail                                  buffer end
-                                                    (new record will be saved here)
+|length| string |htgnel| *** |      free      |length| string |htgnel| *** |         |
+|<---- record  ------->| *** |                |<-- oldest record --->| *** |         |
+^                            ^                ^                            ^         ^
+&buffer[0]                   tail             head                         wrap      buffer end
+                             (new record will be saved here)
 -------------------------------------------------------------------------------------------
 
-Let the data type of `length` be `len_t`,
-then the value of length: length = strlen(string) + 1 + 2*sizeof(len_t)
+A record is never split, when the new record doesn't fit between `tail` and the buffer end,
+the end of the data is marked by `wrap` and the new record is saved at the beginning of the buffer.
+Old records are evicted by advancing `head`, nothing is moved.
+When the records don't wrap around, `wrap` is NULL and the records lie in [head, tail).
+
+`length` is the size of the record body (everything between the two lengths):
+  length = strlen(string) + 1 + HISTORY_SIG_SIZE + (size of prefix)
+It is saved as a varint (7 bits per byte, least significant group first, the highest bit of a byte
+is set if more bytes follow) before the body, and the same bytes in reverse order after the body,
+so the record can be walked over from both ends. Short records take 1 byte for each length.
+
+If CONFIG_SHELL_HIST_SEARCH_FILTER is enabled, a 32-bit signature of the characters in the string
+is saved after the front `length` (HISTORY_SIG_SIZE is 4, otherwise 0), the search skips the
+records whose signature doesn't contain all characters of the pattern.
+
+If CONFIG_SHELL_HIST_DELTA is enabled, a `prefix` (varint) is saved before the string, the record
+only keeps the string after the first `prefix` characters, which are shared with the next (newer)
+record. The last record and every HISTORY_KEYFRAME_INTERVAL-th record keep the whole string
+(`prefix` is 0), so:
+  - walking backward decodes a record from the one after it,
+  - walking forward decodes from the nearest whole record after it (at most
+    HISTORY_KEYFRAME_INTERVAL records away),
+  - evicting the oldest record doesn't break any other record.
+The last record is re-encoded when a new record is added after it.
+
+One more record is reserved for the space which may be left unused at the buffer end.
 */
 
-#define TOTAL_BUFFER_SIZE \
-  (CONFIG_SHELL_HIST_MIN_RECORD * (CONFIG_SHELL_INPUT_BUFFSIZE + 1 + 2 * sizeof(len_t)))
+#if CONFIG_SHELL_HIST_SEARCH_FILTER
+#if !CONFIG_SHELL_HIST_SEARCH
+  #error "CONFIG_SHELL_HIST_SEARCH_FILTER requires CONFIG_SHELL_HIST_SEARCH."
+#endif
+  typedef uint32_t hist_sig_t;
+#endif /* CONFIG_SHELL_HIST_SEARCH_FILTER */
 
-static char historyBuffer[TOTAL_BUFFER_SIZE];  // history buffer
+#if CONFIG_SHELL_HIST_DELTA
+  #define HISTORY_KEYFRAME_INTERVAL 16
+#endif /* CONFIG_SHELL_HIST_DELTA */
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+#include "nano_shell_ctx.h"
+
+// every shell context has its own history (`rl_history_ctx_t`).
+  #define historyBuffer (nano_shell_ctx->hist.buffer)
+  #define historyHead (nano_shell_ctx->hist.head)
+  #define historyTail (nano_shell_ctx->hist.tail)
+  #define historyWrap (nano_shell_ctx->hist.wrap)
+  #define historyCursor (nano_shell_ctx->hist.cursor)
+  #define historyText (nano_shell_ctx->hist.text)
+  #define historyDeltaCount (nano_shell_ctx->hist.delta_count)
+  #define historyStoreBatch (nano_shell_ctx->hist.store_batch)
+  #define historyStoreBatchLen (nano_shell_ctx->hist.store_batch_len)
+  #define historyStoreEnd (nano_shell_ctx->hist.store_end)
+  #define historyStoreLoaded (nano_shell_ctx->hist.store_loaded)
+  #define historyStoreStamp (nano_shell_ctx->hist.store_stamp)
+#else
+static char historyBuffer[HISTORY_BUFFER_SIZE];  // history buffer
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
 
 #define HISTORY_BUFFER_BEGIN() (&historyBuffer[0])
-#define HISTORY_BUFFER_END() (&historyBuffer[TOTAL_BUFFER_SIZE])
+#define HISTORY_BUFFER_END() (&historyBuffer[HISTORY_BUFFER_SIZE])
 
-#define GET_RECORD_SIZE(pRecord) ((len_t)(*((len_t *)(pRecord))))
+#define HISTORY_IS_EMPTY() (historyWrap == NULL && historyHead == historyTail)
 
+#if !CONFIG_SHELL_MULTI_INSTANCE
+static char *historyHead = HISTORY_BUFFER_BEGIN();    // the oldest record
+static char *historyTail = HISTORY_BUFFER_BEGIN();    // new record will be saved here
+static char *historyWrap = NULL;                      // end of the records before wrapping around
 static char *historyCursor = HISTORY_BUFFER_BEGIN();
-static char *historyTail = HISTORY_BUFFER_BEGIN();  // new record will be saved here
+
+#if CONFIG_SHELL_HIST_DELTA
+// the string of the record pointed by `historyCursor` (valid if the cursor doesn't point to the tail).
+static char historyText[CONFIG_SHELL_INPUT_BUFFSIZE + 1];
+
+// the number of records saved with a prefix since the last whole record.
+static unsigned int historyDeltaCount;
+#endif /* CONFIG_SHELL_HIST_DELTA */
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+#if CONFIG_SHELL_HIST_STORE
+static void history_store_load(void);
+#else
+  #define history_store_load()
+#endif /* CONFIG_SHELL_HIST_STORE */
+
+
+/******************************** record encoding ********************************/
+
+static unsigned int history_varint_size(unsigned int val)
+{
+  unsigned int size = 1;
+
+  while (val >= 0x80) {
+    val >>= 7;
+    size++;
+  }
+  return size;
+}
+
+// save `val` at `p`, return the position after it.
+static char *history_put_varint(char *p, unsigned int val)
+{
+  while (val >= 0x80) {
+    *p++ = (char)(val | 0x80);
+    val >>= 7;
+  }
+  *p++ = (char)val;
+  return p;
+}
+
+// save `val` before `end` in reverse order.
+static void history_put_varint_rev(char *end, unsigned int val)
+{
+  while (val >= 0x80) {
+    *--end = (char)(val | 0x80);
+    val >>= 7;
+  }
+  *--end = (char)val;
+}
+
+// read the varint at `p`, return the position after it.
+static char *history_get_varint(char *p, unsigned int *val)
+{
+  unsigned int shift = 0;
+  unsigned char ch;
+
+  *val = 0;
+  do {
+    ch = (unsigned char)*p++;
+    *val |= (unsigned int)(ch & 0x7F) << shift;
+    shift += 7;
+  } while (ch & 0x80);
+
+  return p;
+}
+
+// read the varint saved in reverse order before `end`, return the position of its first byte.
+static char *history_get_varint_rev(char *end, unsigned int *val)
+{
+  unsigned int shift = 0;
+  unsigned char ch;
+
+  *val = 0;
+  do {
+    ch = (unsigned char)*--end;
+    *val |= (unsigned int)(ch & 0x7F) << shift;
+    shift += 7;
+  } while (ch & 0x80);
+
+  return end;
+}
+
+// the end of the record `pRecord`.
+static char *history_record_end(char *pRecord)
+{
+  unsigned int bodySize;
+  char *body = history_get_varint(pRecord, &bodySize);
+
+  return body + bodySize + (body - pRecord);
+}
+
+// the start of the record which ends at `end`.
+static char *history_record_start(char *end)
+{
+  unsigned int bodySize;
+  char *bodyEnd = history_get_varint_rev(end, &bodySize);
+
+  return bodyEnd - bodySize - (end - bodyEnd);
+}
+
+// the string (or the part after the prefix) of the record `pRecord`.
+static char *history_record_text(char *pRecord, unsigned int *prefix)
+{
+  unsigned int bodySize;
+  char *p = history_get_varint(pRecord, &bodySize) + HISTORY_SIG_SIZE;
+
+#if CONFIG_SHELL_HIST_DELTA
+  p = history_get_varint(p, prefix);
+#else
+  *prefix = 0;
+#endif /* CONFIG_SHELL_HIST_DELTA */
+
+  return p;
+}
+
+/**
+ * save a record at `pRecord`, whose string is `text` (the first `prefix` characters are omitted),
+ * `text` may be inside the record. return the end of the record.
+ */
+static char *history_put_record(char *pRecord, const char *text, unsigned int prefix, const void *sig)
+{
+  unsigned int textSize = strlen(text) + 1;
+  unsigned int bodySize = HISTORY_SIG_SIZE + textSize;
+  char *p;
+
+#if CONFIG_SHELL_HIST_DELTA
+  bodySize += history_varint_size(prefix);
+#else
+  (void)prefix;
+#endif /* CONFIG_SHELL_HIST_DELTA */
+
+  // move the string first, it may be inside the record.
+  p = pRecord + history_varint_size(bodySize) + bodySize - textSize;
+  memmove(p, text, textSize);
+
+  p = history_put_varint(pRecord, bodySize);
+#if CONFIG_SHELL_HIST_SEARCH_FILTER
+  memcpy(p, sig, HISTORY_SIG_SIZE);
+  p += HISTORY_SIG_SIZE;
+#else
+  (void)sig;
+#endif /* CONFIG_SHELL_HIST_SEARCH_FILTER */
+#if CONFIG_SHELL_HIST_DELTA
+  p = history_put_varint(p, prefix);
+#endif /* CONFIG_SHELL_HIST_DELTA */
+
+  p += textSize + history_varint_size(bodySize);
+  history_put_varint_rev(p, bodySize);
+
+  return p;
+}
+
+
+#if CONFIG_SHELL_HIST_SEARCH_FILTER
+// one bit for every character in `str` (modulo 32).
+static hist_sig_t history_sig(const char *str)
+{
+  hist_sig_t sig = 0;
+
+  while (*str) {
+    sig |= ((hist_sig_t)1) << (*str++ & 31);
+  }
+  return sig;
+}
+
+// the signature saved in the record `pRecord`.
+static hist_sig_t history_record_sig(char *pRecord)
+{
+  unsigned int bodySize;
+  hist_sig_t sig;
+
+  memcpy(&sig, history_get_varint(pRecord, &bodySize), HISTORY_SIG_SIZE);
+  return sig;
+}
+#endif /* CONFIG_SHELL_HIST_SEARCH_FILTER */
+
+
+/******************************** record walking ********************************/
+
+// the record before `pRecord`, NULL if `pRecord` is the first one.
+static char *history_prev_record(char *pRecord)
+{
+  if (HISTORY_IS_EMPTY() || pRecord == historyHead) {
+    return NULL;
+  }
+
+  if (pRecord == HISTORY_BUFFER_BEGIN() && historyWrap) {
+    pRecord = historyWrap;
+  }
+  return history_record_start(pRecord);
+}
+
+
+// the record after `pRecord`, NULL if `pRecord` is the last one.
+static char *history_next_record(char *pRecord)
+{
+  char *next;
+
+  if (pRecord == historyTail) {
+    return NULL;
+  }
+
+  next = history_record_end(pRecord);
+  if (next == historyWrap) {
+    next = HISTORY_BUFFER_BEGIN();
+  }
+  return (next == historyTail ? NULL : next);
+}
+
+
+#if CONFIG_SHELL_HIST_DELTA
+// decode `pRecord` into `historyText`, which holds the string of the record after it.
+static void history_decode_prev(char *pRecord)
+{
+  unsigned int prefix;
+  char *text = history_record_text(pRecord, &prefix);
+
+  strcpy(historyText + prefix, text);
+}
+
+// decode `pRecord` into `historyText`, start from the nearest whole record after it.
+static void history_decode(char *pRecord)
+{
+  unsigned int prefix;
+  char *tmp = pRecord;
+  char *text = history_record_text(tmp, &prefix);
+
+  while (prefix != 0) {
+    tmp = history_next_record(tmp);
+    text = history_record_text(tmp, &prefix);
+  }
+
+  strcpy(historyText, text);
+  while (tmp != pRecord) {
+    tmp = history_prev_record(tmp);
+    history_decode_prev(tmp);
+  }
+}
+
+  #define HISTORY_TEXT(pRecord) historyText
+#else
+  // the string of the record `pRecord`.
+  static char *history_text(char *pRecord)
+  {
+    unsigned int prefix;
+    return history_record_text(pRecord, &prefix);
+  }
+
+  #define HISTORY_TEXT(pRecord) history_text(pRecord)
+#endif /* CONFIG_SHELL_HIST_DELTA */
 
 
 char *rl_history_next(void)
 {
-  if (historyCursor >= historyTail ||                                // cursor point to the tail
-      historyCursor + GET_RECORD_SIZE(historyCursor) >= historyTail  // cursor point to the last one
-  ) {
+  char *next = history_next_record(historyCursor);
+
+  if (next == NULL) {  // cursor point to the tail or the last one
     return NULL;
   }
 
-  historyCursor += GET_RECORD_SIZE(historyCursor);
-  return historyCursor + sizeof(len_t);
+  historyCursor = next;
+#if CONFIG_SHELL_HIST_DELTA
+  history_decode(historyCursor);
+#endif /* CONFIG_SHELL_HIST_DELTA */
+  return HISTORY_TEXT(historyCursor);
 }
 
 
 char *rl_history_prev(void)
 {
-  if (historyTail != HISTORY_BUFFER_BEGIN() &&  // buffer is not empty
-      historyCursor > HISTORY_BUFFER_BEGIN()    // cursor does not point to the first
-  ) {
-    historyCursor -= GET_RECORD_SIZE(historyCursor - sizeof(len_t));
-    return historyCursor + sizeof(len_t);
+  char *prev;
+
+  history_store_load();
+  prev = history_prev_record(historyCursor);
+
+  if (prev == NULL) {  // cursor point to the first
+    return NULL;
   }
 
+  historyCursor = prev;
+#if CONFIG_SHELL_HIST_DELTA
+  history_decode_prev(historyCursor);
+#endif /* CONFIG_SHELL_HIST_DELTA */
+  return HISTORY_TEXT(historyCursor);
+}
+
+
+#if CONFIG_SHELL_HIST_SEARCH
+char *rl_history_search(const char *pattern, int skip)
+{
+  char *pRecord;
+#if CONFIG_SHELL_HIST_SEARCH_FILTER
+  hist_sig_t sig = history_sig(pattern);
+#endif /* CONFIG_SHELL_HIST_SEARCH_FILTER */
+
+  history_store_load();
+  pRecord = historyCursor;
+
+  if (skip || pRecord == historyTail) {
+    pRecord = history_prev_record(pRecord);
+#if CONFIG_SHELL_HIST_DELTA
+    if (pRecord) {
+      history_decode_prev(pRecord);
+    }
+#endif /* CONFIG_SHELL_HIST_DELTA */
+  }
+
+  while (pRecord) {
+#if CONFIG_SHELL_HIST_SEARCH_FILTER
+    if ((history_record_sig(pRecord) & sig) == sig)
+#endif /* CONFIG_SHELL_HIST_SEARCH_FILTER */
+    {
+      if (strstr(HISTORY_TEXT(pRecord), pattern)) {
+        historyCursor = pRecord;
+        return HISTORY_TEXT(pRecord);
+      }
+    }
+
+    pRecord = history_prev_record(pRecord);
+#if CONFIG_SHELL_HIST_DELTA
+    if (pRecord) {
+      history_decode_prev(pRecord);
+    }
+#endif /* CONFIG_SHELL_HIST_DELTA */
+  }
+
+#if CONFIG_SHELL_HIST_DELTA
+  if (historyCursor != historyTail) {  // restore the string of the current record.
+    history_decode(historyCursor);
+  }
+#endif /* CONFIG_SHELL_HIST_DELTA */
+
   return NULL;
 }
+#endif /* CONFIG_SHELL_HIST_SEARCH */
 
 
-void rl_history_add(char *input)
+/******************************** record adding ********************************/
+
+#if CONFIG_SHELL_HIST_DELTA
+// re-encode the last record with the prefix shared with `input`, which will be added after it.
+static void history_encode_last(const char *input)
 {
-  size_t freeSpace = HISTORY_BUFFER_END() - historyTail;
+  char *pRecord = history_prev_record(historyTail);
+  unsigned int prefix = 0, tmp;
+  char *text;
+
+  if (pRecord == NULL) {
+    return;
+  }
+
+  text = history_record_text(pRecord, &tmp);
+  if (++historyDeltaCount < HISTORY_KEYFRAME_INTERVAL) {
+    while (text[prefix] != '\0' && text[prefix] == input[prefix]) {
+      prefix++;
+    }
+  }
+
+  if (prefix == 0) {  // keep the whole string.
+    historyDeltaCount = 0;
+    return;
+  }
+
+  // the record only gets shorter.
+#if CONFIG_SHELL_HIST_SEARCH_FILTER
+  {
+    hist_sig_t sig = history_record_sig(pRecord);
+    historyTail = history_put_record(pRecord, text + prefix, prefix, &sig);
+  }
+#else
+  historyTail = history_put_record(pRecord, text + prefix, prefix, NULL);
+#endif /* CONFIG_SHELL_HIST_SEARCH_FILTER */
+}
+#endif /* CONFIG_SHELL_HIST_DELTA */
 
-  len_t inputLength = strlen(input) + 1;
-  len_t newRecordLength = inputLength + 2 * sizeof(len_t);
 
-  if (freeSpace < newRecordLength) {
-    len_t tmpLength;
-    char *tmpRecord = HISTORY_BUFFER_BEGIN();
-    do {
-      tmpLength = GET_RECORD_SIZE(tmpRecord);
-      freeSpace += tmpLength;
-      tmpRecord += tmpLength;
-    } while (freeSpace < newRecordLength);
+// save `input` as a whole record after the last one.
+static void history_append(const char *input)
+{
+  unsigned int bodySize = strlen(input) + 1 + HISTORY_SIG_SIZE + (HISTORY_PREFIX_SIZE ? 1 : 0);
+  unsigned int newRecordLength = bodySize + 2 * history_varint_size(bodySize);
+#if CONFIG_SHELL_HIST_SEARCH_FILTER
+  hist_sig_t sig = history_sig(input);
+#endif /* CONFIG_SHELL_HIST_SEARCH_FILTER */
 
-    memmove(HISTORY_BUFFER_BEGIN(), tmpRecord, historyTail - tmpRecord);
-    historyTail -= (tmpRecord - HISTORY_BUFFER_BEGIN());
+  for (;;) {
+    if (historyWrap == NULL) {
+      if ((unsigned int)(HISTORY_BUFFER_END() - historyTail) >= newRecordLength) {
+        break;
+      }
+      if (historyHead == historyTail) {  // empty
+        historyHead = historyTail = HISTORY_BUFFER_BEGIN();
+        continue;
+      }
+      // wrap around, save the new record at the beginning.
+      historyWrap = historyTail;
+      historyTail = HISTORY_BUFFER_BEGIN();
+    } else {
+      // keep `tail` away from `head`, or the cursor at the tail can't be told from the first record.
+      if ((unsigned int)(historyHead - historyTail) > newRecordLength) {
+        break;
+      }
+      // evict the oldest record.
+      historyHead = history_record_end(historyHead);
+      if (historyHead == historyWrap) {
+        historyHead = HISTORY_BUFFER_BEGIN();
+        historyWrap = NULL;
+      }
+    }
   }
 
-  /* put the new record in the history buffer */
-  *((len_t *)historyTail) = newRecordLength;
-  memcpy(historyTail + sizeof(len_t), input, inputLength);
-  historyTail += newRecordLength;  // move tail to the end of the new record
-  *((len_t *)(historyTail - sizeof(len_t))) = newRecordLength;
+  /* put the new record in the history buffer, and move tail to the end of it */
+#if CONFIG_SHELL_HIST_SEARCH_FILTER
+  historyTail = history_put_record(historyTail, input, 0, &sig);
+#else
+  historyTail = history_put_record(historyTail, input, 0, NULL);
+#endif /* CONFIG_SHELL_HIST_SEARCH_FILTER */
 
   /* set cursor point to the end */
   historyCursor = historyTail;
 }
 
 
+// add a new record, return 0 if it is not added (the same as the last one).
+static int history_add(const char *input)
+{
+#if CONFIG_SHELL_HIST_DELTA
+  char *pLast = history_prev_record(historyTail);
+  unsigned int prefix;
+
+  historyCursor = historyTail;
+  if (pLast && strcmp(history_record_text(pLast, &prefix), input) == 0) {  // the same as the last one.
+    return 0;
+  }
+
+  history_encode_last(input);
+#endif /* CONFIG_SHELL_HIST_DELTA */
+
+  history_append(input);
+  return 1;
+}
+
+
+// drop the last record.
+static void history_drop_last(void)
+{
+  historyTail = history_record_start(historyTail);
+  if (historyTail == HISTORY_BUFFER_BEGIN() && historyWrap) {
+    historyTail = historyWrap;
+    historyWrap = NULL;
+  }
+}
+
+
+// remove the last record, return 0 if the history is empty.
+static int history_rm_last(void)
+{
+  if (HISTORY_IS_EMPTY()) {
+    return 0;
+  }
+
+#if CONFIG_SHELL_HIST_DELTA
+  {
+    char *pRecord = history_prev_record(history_prev_record(historyTail));
+
+    if (pRecord) {  // the record before the last one is decoded from it, save it as a whole record.
+      history_decode(pRecord);
+      history_drop_last();
+      history_drop_last();
+      history_append(historyText);
+      historyDeltaCount = 0;
+      return 1;
+    }
+  }
+#endif /* CONFIG_SHELL_HIST_DELTA */
+
+  history_drop_last();
+  historyCursor = historyTail;
+  return 1;
+}
+
+
+/******************************** persistent storage ********************************/
+
+#if CONFIG_SHELL_HIST_STORE
+
+#if (CONFIG_SHELL_HIST_STORE_SIZE < 2 * (CONFIG_SHELL_INPUT_BUFFSIZE + 1))
+#error "CONFIG_SHELL_HIST_STORE_SIZE must be no less than 2*(CONFIG_SHELL_INPUT_BUFFSIZE+1)."
+#endif
+
+#if !(CONFIG_SHELL_HIST_STORE_BATCH > 0)
+#error "the value of CONFIG_SHELL_HIST_STORE_BATCH must be greater than 0!"
+#endif
+
+#if defined(__GNUC__)
+#ifndef __weak
+#define __weak __attribute__((weak))
+#endif /* __weak */
+#endif /* __GNUC__ */
+
+/**
+log view of the storage (append-only):
+
+--------------------------------------------------------------------------
+| string | '\0' | string | '\0' | *** | string | '\0' | 0xFF 0xFF ... (erased) |
+^                                                      ^
+offset 0                                               historyStoreEnd
+--------------------------------------------------------------------------
+
+The strings are saved in the order they are added, the log ends at the first 0xFF (which is never
+a character of the input) or at the end of the data that can be read.
+At startup the log is read once from the beginning and every record is added to the history buffer.
+A record which is not ended by '\0' (power lost while writing it) is closed by HISTORY_STORE_BROKEN
+and '\0', a record containing a non-text character is skipped.
+Removing the last record appends HISTORY_STORE_REMOVED (if the record has been written).
+When the log is full, it is erased and the newest records in the history buffer (which fill half of
+the log at most) are written back.
+*/
+
+#define HISTORY_STORE_BROKEN ((char)0x18)  // CAN, never a character of the input
+#define HISTORY_STORE_REMOVED "\x7F"        // DEL, a record meaning "remove the last record"
+
+#if !CONFIG_SHELL_MULTI_INSTANCE
+static char historyStoreBatch[CONFIG_SHELL_HIST_STORE_BATCH];  // the records not written yet
+static unsigned int historyStoreBatchLen;
+static unsigned int historyStoreEnd;  // the end of the data in the log
+static signed char historyStoreLoaded;  // 0: not loaded yet, 1: loaded, -1: the storage failed.
+#if CONFIG_SHELL_HIST_STORE_DELAY > 0
+static unsigned long historyStoreStamp;  // tick (see `shell_tick_ms()`) of the last record
+#endif /* CONFIG_SHELL_HIST_STORE_DELAY > 0 */
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+
+__weak int history_store_read(unsigned int offset, void *buf, unsigned int len)
+{
+  (void)offset;
+  (void)buf;
+  (void)len;
+  return 0;
+}
+
+
+__weak int history_store_write(unsigned int offset, const void *buf, unsigned int len)
+{
+  (void)offset;
+  (void)buf;
+  (void)len;
+  return -1;
+}
+
+
+__weak int history_store_erase(void)
+{
+  return -1;
+}
+
+
+// the log can't be trusted after a failure of the storage, stop saving the records.
+static void history_store_fail(void)
+{
+  historyStoreLoaded = -1;
+  historyStoreBatchLen = 0;
+}
+
+
+// write `size` bytes of `data` at the end of the log.
+static void history_store_put(const void *data, unsigned int size)
+{
+  if (history_store_write(historyStoreEnd, data, size) != 0) {
+    history_store_fail();
+  } else {
+    historyStoreEnd += size;
+  }
+}
+
+
+// write the batch to the log, the caller makes sure that it fits.
+static void history_store_write_batch(void)
+{
+  if (historyStoreBatchLen > 0 && historyStoreLoaded > 0) {
+    history_store_put(historyStoreBatch, historyStoreBatchLen);
+    historyStoreBatchLen = 0;
+  }
+}
+
+
+// add `size` bytes of `data` to the batch, the caller makes sure that they fit in the log.
+static void history_store_stage(const char *data, unsigned int size)
+{
+  if (historyStoreBatchLen + size > CONFIG_SHELL_HIST_STORE_BATCH) {
+    history_store_write_batch();
+  }
+
+  if (historyStoreLoaded < 0) {
+    return;
+  }
+
+  if (size > CONFIG_SHELL_HIST_STORE_BATCH) {  // larger than the batch, write it directly.
+    history_store_put(data, size);
+  } else {
+    memcpy(historyStoreBatch + historyStoreBatchLen, data, size);
+    historyStoreBatchLen += size;
+  }
+}
+
+
+// erase the log and write the newest records in the history buffer back.
+static void history_store_compact(void)
+{
+  char *pRecord = historyTail, *prev;
+  unsigned int total = 0;
+
+  historyStoreEnd = 0;
+  historyStoreBatchLen = 0;
+  if (history_store_erase() != 0) {
+    history_store_fail();
+    return;
+  }
+
+  // find the oldest record to be written, the records fill half of the log at most.
+  while ((prev = history_prev_record(pRecord)) != NULL) {
+#if CONFIG_SHELL_HIST_DELTA
+    history_decode_prev(prev);
+#endif /* CONFIG_SHELL_HIST_DELTA */
+    total += strlen(HISTORY_TEXT(prev)) + 1;
+    if (total > CONFIG_SHELL_HIST_STORE_SIZE / 2) {
+      break;
+    }
+    pRecord = prev;
+  }
+
+  while (pRecord && pRecord != historyTail) {
+#if CONFIG_SHELL_HIST_DELTA
+    history_decode(pRecord);
+#endif /* CONFIG_SHELL_HIST_DELTA */
+    history_store_stage(HISTORY_TEXT(pRecord), strlen(HISTORY_TEXT(pRecord)) + 1);
+    pRecord = history_next_record(pRecord);
+  }
+  history_store_write_batch();
+
+#if CONFIG_SHELL_HIST_DELTA
+  if (historyCursor != historyTail) {  // restore the string of the current record.
+    history_decode(historyCursor);
+  }
+#endif /* CONFIG_SHELL_HIST_DELTA */
+}
+
+
+// save the new record `input` (already added to the history buffer) to the log.
+static void history_store_append(const char *input)
+{
+  unsigned int size = strlen(input) + 1;
+
+  if (historyStoreLoaded < 0) {
+    return;
+  }
+
+  if (historyStoreEnd + historyStoreBatchLen + size > CONFIG_SHELL_HIST_STORE_SIZE) {
+    history_store_compact();
+  } else {
+    history_store_stage(input, size);
+  }
+
+#if CONFIG_SHELL_HIST_STORE_DELAY > 0
+  historyStoreStamp = shell_tick_ms();
+#endif /* CONFIG_SHELL_HIST_STORE_DELAY > 0 */
+}
+
+
+// the last record is removed from the history buffer, remove it from the batch if not written yet.
+static void history_store_rm_last(void)
+{
+  unsigned int start = historyStoreBatchLen;
+
+  if (start > 0) {
+    start--;  // '\0' of the last record in the batch
+    while (start > 0 && historyStoreBatch[start - 1] != '\0') {
+      start--;
+    }
+    if (historyStoreBatch[start] != HISTORY_STORE_REMOVED[0]) {
+      historyStoreBatchLen = start;
+      return;
+    }
+  }
+
+  history_store_append(HISTORY_STORE_REMOVED);
+}
+
+
+// read the log and add the records to the history buffer, only once.
+static void history_store_load(void)
+{
+  char line[CONFIG_SHELL_INPUT_BUFFSIZE + 1];
+  unsigned int lineLen = 0, offset = 0;
+  int broken = 0, removed = 0, count = 0, i = 0;
+
+  if (historyStoreLoaded) {
+    return;
+  }
+  historyStoreLoaded = 1;
+
+  // read the log through the batch buffer, which is empty now.
+  while (offset < CONFIG_SHELL_HIST_STORE_SIZE) {
+    count = history_store_read(offset, historyStoreBatch, CONFIG_SHELL_HIST_STORE_BATCH);
+    if (count <= 0) {
+      break;
+    }
+    if ((unsigned int)count > CONFIG_SHELL_HIST_STORE_SIZE - offset) {
+      count = CONFIG_SHELL_HIST_STORE_SIZE - offset;
+    }
+
+    for (i = 0; i < count && historyStoreBatch[i] != (char)0xFF; i++) {
+      char ch = historyStoreBatch[i];
+
+      if (ch == '\0') {
+        line[lineLen] = '\0';
+        if (removed && lineLen == 0 && !broken) {
+          history_rm_last();
+        } else if (lineLen > 0 && !broken) {
+          history_add(line);
+        }
+        lineLen = 0;
+        broken = 0;
+        removed = 0;
+      } else if (ch == HISTORY_STORE_REMOVED[0] && lineLen == 0 && !removed) {
+        removed = 1;
+      } else if (lineLen < CONFIG_SHELL_INPUT_BUFFSIZE && !removed && (unsigned char)ch >= ' ' && ch != 127) {
+        line[lineLen++] = ch;
+      } else {
+        broken = 1;
+      }
+    }
+
+    offset += i;
+    if ((unsigned int)i < CONFIG_SHELL_HIST_STORE_BATCH) {  // erased or no more data
+      break;
+    }
+  }
+  historyStoreEnd = offset;
+
+  if (lineLen > 0 || broken || removed) {  // the last record is not ended, close it.
+    static const char closing[] = { HISTORY_STORE_BROKEN, '\0' };
+
+    if (historyStoreEnd + sizeof(closing) > CONFIG_SHELL_HIST_STORE_SIZE) {
+      history_store_compact();
+    } else {
+      history_store_put(closing, sizeof(closing));
+    }
+  }
+}
+
+
+void rl_history_flush(void)
+{
+  history_store_write_batch();
+}
+
+
+void rl_history_poll(void)
+{
+#if CONFIG_SHELL_HIST_STORE_DELAY > 0
+  if (historyStoreBatchLen == 0 || shell_tick_ms() - historyStoreStamp < CONFIG_SHELL_HIST_STORE_DELAY) {
+    return;
+  }
+#endif /* CONFIG_SHELL_HIST_STORE_DELAY > 0 */
+  history_store_write_batch();
+}
+
+#else
+  #define history_store_rm_last()
+#endif /* CONFIG_SHELL_HIST_STORE */
+
+
+void rl_history_add(char *input)
+{
+#if CONFIG_SHELL_HIST_STORE
+  history_store_load();
+  if (history_add(input)) {
+    history_store_append(input);
+  }
+#else
+  history_add(input);
+#endif /* CONFIG_SHELL_HIST_STORE */
+}
+
+
 void rl_history_rm_last(void)
 {
-  if (historyTail > HISTORY_BUFFER_BEGIN()) {
-    historyTail -= GET_RECORD_SIZE(historyTail - sizeof(len_t));
-    historyCursor = historyTail;
+  history_store_load();
+
+  if (history_rm_last()) {
+    history_store_rm_last();
   }
 }
 
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+void rl_history_ctx_init(rl_history_ctx_t *hist)
+{
+  hist->head = hist->tail = hist->cursor = hist->buffer;
+}
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
 #endif /* CONFIG_SHELL_HIST_MIN_RECORD > 0 */
@@ -12,6 +12,34 @@
 #ifndef __NANO_SHELL_HISTORY_H
 #define __NANO_SHELL_HISTORY_H
 
+#include "shell_config.h"
+
+
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0
+/* size of the history buffer, see the memory view in @file{history.c} */
+
+// the number of bytes of the varint `n`, `n` is a constant expression.
+#define HISTORY_VARINT_SIZE(n) ((n) < 0x80 ? 1 : (n) < 0x4000 ? 2 : (n) < 0x200000 ? 3 : 4)
+
+#if CONFIG_SHELL_HIST_SEARCH_FILTER
+  #define HISTORY_SIG_SIZE 4
+#else
+  #define HISTORY_SIG_SIZE 0
+#endif /* CONFIG_SHELL_HIST_SEARCH_FILTER */
+
+#if CONFIG_SHELL_HIST_DELTA
+  #define HISTORY_PREFIX_SIZE HISTORY_VARINT_SIZE(CONFIG_SHELL_INPUT_BUFFSIZE)
+#else
+  #define HISTORY_PREFIX_SIZE 0
+#endif /* CONFIG_SHELL_HIST_DELTA */
+
+#define HISTORY_MAX_BODY_SIZE (CONFIG_SHELL_INPUT_BUFFSIZE + 1 + HISTORY_SIG_SIZE + HISTORY_PREFIX_SIZE)
+
+#define HISTORY_MAX_RECORD_SIZE (HISTORY_MAX_BODY_SIZE + 2 * HISTORY_VARINT_SIZE(HISTORY_MAX_BODY_SIZE))
+
+#define HISTORY_BUFFER_SIZE ((CONFIG_SHELL_HIST_MIN_RECORD + 1) * HISTORY_MAX_RECORD_SIZE)
+#endif /* CONFIG_SHELL_HIST_MIN_RECORD > 0 */
+
 
 /**
  * @brief add a new record
@@ -37,10 +65,112 @@ char *rl_history_next(void);
 char *rl_history_prev(void);
 
 
+#if CONFIG_SHELL_HIST_SEARCH
+/**
+ * @brief Search backward for the record containing `pattern`, the record found becomes the current
+ * record (`rl_history_prev/next()` continue from it).
+ *
+ * @param pattern: the string to search for.
+ * @param skip: 0: start from the current record (the last record if there is no current record).
+ *              1: start from the record before the current record.
+ * @return char*: the record found, NULL if not found (the current record is not changed).
+ */
+char *rl_history_search(const char *pattern, int skip);
+#endif /* CONFIG_SHELL_HIST_SEARCH */
+
+
 /**
  * @brief Remove last record
  *
  */
 void rl_history_rm_last(void);
 
+
+#if CONFIG_SHELL_HIST_STORE
+/**
+ * @brief Write the records collected in the batch buffer to the storage.
+ *        call it when the system is idle or before reset, so the newest records are not lost.
+ *        (the default shell_idle() calls it.)
+ *
+ */
+void rl_history_flush(void);
+
+
+/**
+ * @brief Write the records collected in the batch buffer to the storage if no record has been
+ *        added for CONFIG_SHELL_HIST_STORE_DELAY ms (at once if it is 0).
+ *        called by `readline()` while waiting for input and by `nano_shell_poll()`.
+ *
+ */
+void rl_history_poll(void);
+
+
+/*********************************************************************
+   nano-shell uses these functions to access the persistent storage of the history.
+   The default (weak) implementations do nothing, implement them in your project
+   (or enable CONFIG_SHELL_HIST_STORE_POSIX on a host).
+ *********************************************************************/
+
+/**
+ * @brief Read `len` bytes at `offset` of the storage.
+ *
+ * @return int: the number of bytes read, less than `len` if the end of the storage is reached.
+ *              erased storage may read as 0xFF.
+ */
+int history_store_read(unsigned int offset, void *buf, unsigned int len);
+
+
+/**
+ * @brief Write `len` bytes at `offset` of the storage. the offset only grows between two erases,
+ *        and the bytes at [offset, offset+len) have never been written since the last erase.
+ *
+ * @return int: 0 on success. if writing or erasing fails, the records are no longer saved until
+ *              reset (they are still kept in the history buffer).
+ */
+int history_store_write(unsigned int offset, const void *buf, unsigned int len);
+
+
+/**
+ * @brief Erase the whole storage (CONFIG_SHELL_HIST_STORE_SIZE bytes).
+ *
+ * @return int: 0 on success.
+ */
+int history_store_erase(void);
+#endif /* CONFIG_SHELL_HIST_STORE */
+
+
+#if CONFIG_SHELL_MULTI_INSTANCE && CONFIG_SHELL_HIST_MIN_RECORD > 0
+/**
+ * @brief the history of a shell context (see "nano_shell_ctx.h").
+ *        the fields are the file-scope variables of the single instance build, see @file{history.c}.
+ */
+typedef struct {
+  char buffer[HISTORY_BUFFER_SIZE];
+  char *head;
+  char *tail;
+  char *wrap;
+  char *cursor;
+#if CONFIG_SHELL_HIST_DELTA
+  char text[CONFIG_SHELL_INPUT_BUFFSIZE + 1];
+  unsigned int delta_count;
+#endif /* CONFIG_SHELL_HIST_DELTA */
+#if CONFIG_SHELL_HIST_STORE
+  char store_batch[CONFIG_SHELL_HIST_STORE_BATCH];
+  unsigned int store_batch_len;
+  unsigned int store_end;
+  signed char store_loaded;
+#if CONFIG_SHELL_HIST_STORE_DELAY > 0
+  unsigned long store_stamp;
+#endif /* CONFIG_SHELL_HIST_STORE_DELAY > 0 */
+#endif /* CONFIG_SHELL_HIST_STORE */
+} rl_history_ctx_t;
+
+
+/**
+ * @brief initialize the history `hist` (which has been zeroed).
+ *
+ */
+void rl_history_ctx_init(rl_history_ctx_t *hist);
+#endif /* CONFIG_SHELL_MULTI_INSTANCE && CONFIG_SHELL_HIST_MIN_RECORD > 0 */
+
 #endif /* __NANO_SHELL_HISTORY_H */
@@ -0,0 +1,79 @@
+/**
+ * @file history_store_posix.c
+ * @author Liber (lvlebin@outlook.com)
+ * @brief persistent storage of the history on a POSIX file, for host builds.
+ * @version 1.0
+ * @date 2020-03-18
+ *
+ * @copyright Copyright (c) Liber 2020
+ *
+ */
+
+#include "shell_config.h"
+
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0 && CONFIG_SHELL_HIST_STORE && CONFIG_SHELL_HIST_STORE_POSIX
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "history.h"
+
+// the file is opened at the first access and kept open.
+static int history_store_fd(void)
+{
+  static int fd = -1;
+
+  if (fd < 0) {
+    fd = open(CONFIG_SHELL_HIST_STORE_PATH, O_RDWR | O_CREAT, 0600);
+  }
+  return fd;
+}
+
+
+int history_store_read(unsigned int offset, void *buf, unsigned int len)
+{
+  int fd = history_store_fd();
+  ssize_t count;
+
+  if (fd < 0) {
+    return 0;
+  }
+
+  count = pread(fd, buf, len, offset);
+  return (count < 0 ? 0 : (int)count);
+}
+
+
+int history_store_write(unsigned int offset, const void *buf, unsigned int len)
+{
+  int fd = history_store_fd();
+  ssize_t count;
+
+  if (fd < 0) {
+    return -1;
+  }
+
+  while (len > 0) {
+    count = pwrite(fd, buf, len, offset);
+    if (count <= 0) {
+      return -1;
+    }
+    buf = (const char *)buf + count;
+    offset += count;
+    len -= count;
+  }
+  return 0;
+}
+
+
+int history_store_erase(void)
+{
+  int fd = history_store_fd();
+
+  if (fd < 0) {
+    return -1;
+  }
+  return ftruncate(fd, 0);
+}
+
+#endif /* CONFIG_SHELL_HIST_MIN_RECORD > 0 && CONFIG_SHELL_HIST_STORE && CONFIG_SHELL_HIST_STORE_POSIX */
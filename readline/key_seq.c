@@ -9,90 +9,240 @@
  *
  */
 
-#ifndef __NANO_SEHLL_KEY_SEQ_MAP_H
-#define __NANO_SHELL_KEY_SEQ_MAP_H
-
 #include "key_seq.h"
 #include "shell_io/shell_io.h"
 
 #include "shell_config.h"
 
-extern void rl_get_pre_history(void);   // `up arrow` or `Ctrl P`
-extern void rl_get_next_history(void);  // `down arrow` or `Ctrl N`
-extern void rl_backward_cursor(void);   // `right arrow` or `Ctrl F`
-extern void rl_forward_cursor(void);    // `left arrow` or `Ctrl B`
-extern void rl_line_home(void);         // `Home`
-extern void rl_line_end(void);          // `End`
-extern void rl_delete(void);            // `Delete`
-
 #if CONFIG_SHELL_KEY_SEQ_BIND
 
-const static key_seq_t key_seq_map[] = {
-#if CONFIG_SHELL_HIST_MIN_RECORD > 0
-  {CONVERT_KEY_SEQ('\033', '[', 'A', 0), rl_get_pre_history},   // up arrow
-  {CONVERT_KEY_SEQ('\033', '[', 'B', 0), rl_get_next_history},  // down arrow
-  // {CONVERT_KEY_SEQ('\033', 'O', 'A', 0), rl_get_pre_history},
-  // {CONVERT_KEY_SEQ('\033', 'O', 'B', 0), rl_get_next_history},
+/**
+ * built-in key sequences.
+ * NOTE: MUST be sorted by key code (intro: ESC < 'O' < '['), they are found with binary search.
+ */
+static const key_seq_t key_seq_map[] = {
+#if CONFIG_SHELL_LINE_EDITING
+  {KEY_SEQ_ALT('b'), rl_prev_word},  // Alt-B
+  {KEY_SEQ_ALT('f'), rl_next_word},  // Alt-F
+#endif /* CONFIG_SHELL_LINE_EDITING */
 
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0
+  {KEY_SEQ_SS3('A'), rl_get_pre_history},   // up arrow
+  {KEY_SEQ_SS3('B'), rl_get_next_history},  // down arrow
 #endif /* CONFIG_SHELL_HIST_MIN_RECORD */
-
-
 #if CONFIG_SHELL_LINE_EDITING
-  {CONVERT_KEY_SEQ('\033', '[', 'C', 0), rl_backward_cursor},  // right arrow
-  {CONVERT_KEY_SEQ('\033', '[', 'D', 0), rl_forward_cursor},   // left arrow
-  {CONVERT_KEY_SEQ('\033', '[', 'H', 0), rl_line_home},        // home
-  {CONVERT_KEY_SEQ('\033', '[', 'F', 0), rl_line_end},         // end
-  // {CONVERT_KEY_SEQ('\033', 'O', 'C', 0), rl_forward_cursor},
-  // {CONVERT_KEY_SEQ('\033', 'O', 'D', 0), rl_backward_cursor},
-  // {CONVERT_KEY_SEQ('\033', 'O', 'H', 0), rl_line_home},
-  // {CONVERT_KEY_SEQ('\033', 'O', 'F', 0), rl_line_end},
-
-  {CONVERT_KEY_SEQ('\033', '[', '3', '~'), rl_delete},  // delete
+  {KEY_SEQ_SS3('C'), rl_backward_cursor},  // right arrow
+  {KEY_SEQ_SS3('D'), rl_forward_cursor},   // left arrow
+  {KEY_SEQ_SS3('F'), rl_line_end},         // end
+  {KEY_SEQ_SS3('H'), rl_line_home},        // home
 #endif /* CONFIG_SHELL_LINE_EDITING */
 
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0
+  {KEY_SEQ_CSI('A', 0, 0), rl_get_pre_history},   // up arrow
+  {KEY_SEQ_CSI('B', 0, 0), rl_get_next_history},  // down arrow
+#endif /* CONFIG_SHELL_HIST_MIN_RECORD */
+#if CONFIG_SHELL_LINE_EDITING
+  {KEY_SEQ_CSI('C', 0, 0), rl_backward_cursor},  // right arrow
+  {KEY_SEQ_CSI('C', 1, 5), rl_next_word},        // Ctrl right arrow
+  {KEY_SEQ_CSI('D', 0, 0), rl_forward_cursor},   // left arrow
+  {KEY_SEQ_CSI('D', 1, 5), rl_prev_word},        // Ctrl left arrow
+  {KEY_SEQ_CSI('F', 0, 0), rl_line_end},         // end
+  {KEY_SEQ_CSI('H', 0, 0), rl_line_home},        // home
+  {KEY_SEQ_CSI('~', 1, 0), rl_line_home},        // home (vt220)
+  {KEY_SEQ_CSI('~', 3, 0), rl_delete},           // delete
+  {KEY_SEQ_CSI('~', 4, 0), rl_line_end},         // end (vt220)
+  {KEY_SEQ_CSI('~', 7, 0), rl_line_home},        // home (rxvt)
+  {KEY_SEQ_CSI('~', 8, 0), rl_line_end},         // end (rxvt)
+#endif /* CONFIG_SHELL_LINE_EDITING */
+  {KEY_SEQ_CSI('~', 200, 0), rl_paste_begin},  // bracketed paste start
+  {KEY_SEQ_CSI('~', 201, 0), rl_paste_end},    // bracketed paste end
 };
 
 #define KEY_SEQ_MAP_SIZE (sizeof(key_seq_map) / sizeof(key_seq_t))
 
 
-extern int _rl_key_seq_len;
+/**
+ * state of the decoder, non-zero means a key sequence is in progress.
+ * ESC -> '[' -> (parameter bytes)* -> final byte
+ *     -> 'O' -> final byte
+ *     -> other byte
+ */
+enum {
+  KEY_SEQ_IDLE = 0,
+  KEY_SEQ_ESC,
+  KEY_SEQ_CSI_PARAM,
+  KEY_SEQ_SS3_FINAL,
+};
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+#include "nano_shell_ctx.h"
+
+// every shell context has its own decoder state (`key_seq_ctx_t`).
+  #define _rl_key_seq_state (nano_shell_ctx->key_seq.state)
+  #define _key_seq_arg (nano_shell_ctx->key_seq.arg)
+  #define _key_seq_argc (nano_shell_ctx->key_seq.argc)
+  #define _key_seq_ignored (nano_shell_ctx->key_seq.ignored)
+#else
+int _rl_key_seq_state = KEY_SEQ_IDLE;
 
-void rl_dispatch_seq(char ch)
+static u8 _key_seq_arg[2];
+static u8 _key_seq_argc;     // index of the current parameter.
+static u8 _key_seq_ignored;  // non-zero means the sequence has unsupported parameters.
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+
+#if CONFIG_SHELL_KEY_SEQ_BIND_INDEX > 0
+/**
+ * the bindings added by NANO_SHELL_BIND_KEY() are sorted by the linker by name, not by key code.
+ * `_key_seq_bind_index` points to them sorted by key code (built once at the first key sequence),
+ * `_key_seq_bind_count` is its size, or -1 if there are too many bindings: fall back to linear scan.
+ */
+static const key_seq_t *_key_seq_bind_index[CONFIG_SHELL_KEY_SEQ_BIND_INDEX];
+static int _key_seq_bind_count = -2;  // -2: not built yet.
+
+// build the sorted index (insertion sort, run only once), the first binding of a key wins.
+static void key_seq_build_index(const key_seq_t *start, unsigned int count)
 {
-  static uint32_t key_seq_val, key_seq_mask;
+  if (count > CONFIG_SHELL_KEY_SEQ_BIND_INDEX) {
+    _key_seq_bind_count = -1;
+    return;
+  }
 
-  uint32_t offset, miss_match, tmp_val;
+  for (unsigned int i = 0; i < count; i++) {
+    unsigned int j = i;
+    while (j > 0 && _key_seq_bind_index[j - 1]->key_seq_val > start[i].key_seq_val) {
+      _key_seq_bind_index[j] = _key_seq_bind_index[j - 1];
+      j--;
+    }
+    _key_seq_bind_index[j] = &start[i];
+  }
+  _key_seq_bind_count = (int)count;
+}
+
+static const key_seq_t *key_seq_find_binding(u32 key)
+{
+  unsigned int low = 0, high = (unsigned int)_key_seq_bind_count;
+
+  while (low < high) {  // the lowest entry not less than `key`.
+    unsigned int mid = (low + high) >> 1;
+    if (_key_seq_bind_index[mid]->key_seq_val < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low < (unsigned int)_key_seq_bind_count && _key_seq_bind_index[low]->key_seq_val == key) {
+    return _key_seq_bind_index[low];
+  }
+  return NULL;
+}
+#endif /* CONFIG_SHELL_KEY_SEQ_BIND_INDEX > 0 */
 
-  _rl_key_seq_len++;
 
-  offset = ((uint32_t)(sizeof(uint32_t) - _rl_key_seq_len)) << 3;  // (4-_rl_key_seq_len)*8
-  key_seq_val |= (((uint32_t)ch) << offset);
-  key_seq_mask |= (0xFF << offset);
+static void rl_key_seq_run(u32 key)
+{
+  const key_seq_t *tmp = _shell_entry_start(key_seq_t);
+  unsigned int count = _shell_entry_count(key_seq_t);
+  int low = 0, high = KEY_SEQ_MAP_SIZE - 1, mid;
 
-  miss_match = 1;
-  for (int i = 0; i < KEY_SEQ_MAP_SIZE; i++) {
-    tmp_val = key_seq_map[i].key_seq_val;
-    if ((tmp_val & key_seq_mask) == key_seq_val) {  // partial match
-      if (key_seq_val == tmp_val) {                 // full match
-        key_seq_val = 0;
-        key_seq_mask = 0;
-        _rl_key_seq_len = 0;
+  _rl_key_seq_state = KEY_SEQ_IDLE;
 
-        key_seq_map[i].key_func();
-        return;
-      }
-      miss_match = 0;
+  // bindings added by NANO_SHELL_BIND_KEY()
+#if CONFIG_SHELL_KEY_SEQ_BIND_INDEX > 0
+  if (_key_seq_bind_count == -2) {
+    key_seq_build_index(tmp, count);
+  }
+
+  if (_key_seq_bind_count >= 0) {
+    tmp = key_seq_find_binding(key);
+    if (tmp) {
+      tmp->key_func();
+      return;
     }
+    count = 0;  // not bound, skip the linear scan.
   }
+#endif /* CONFIG_SHELL_KEY_SEQ_BIND_INDEX > 0 */
 
-  if (miss_match) {
-    key_seq_val = 0;
-    key_seq_mask = 0;
-    _rl_key_seq_len = 0;
-    shell_putc('\a');
+  for (unsigned int i = 0; i < count; i++) {
+    if (tmp[i].key_seq_val == key) {
+      tmp[i].key_func();
+      return;
+    }
+  }
+
+  while (low <= high) {
+    mid = (low + high) / 2;
+    if (key_seq_map[mid].key_seq_val == key) {
+      key_seq_map[mid].key_func();
+      return;
+    } else if (key_seq_map[mid].key_seq_val < key) {
+      low = mid + 1;
+    } else {
+      high = mid - 1;
+    }
   }
+
+  shell_putc('\a');  // unknown key sequence, the whole sequence is discarded.
 }
-#endif /* CONFIG_SHELL_KEY_SEQ_BIND */
 
 
-#endif /* __NANO_SHELL_KEY_SEQ_MAP_H */
+int rl_dispatch_seq(char ch)
+{
+  u8 c = (u8)ch;
+
+  if (c < ' ' || c == 127) {  // control characters abort the sequence.
+    if (_rl_key_seq_state != KEY_SEQ_IDLE) {
+      _rl_key_seq_state = KEY_SEQ_IDLE;
+      return 0;
+    }
+    if (ch == '\033') {
+      _rl_key_seq_state = KEY_SEQ_ESC;
+      return 1;
+    }
+    return 0;
+  }
+
+  switch (_rl_key_seq_state) {
+    case KEY_SEQ_ESC:
+      if (ch == '[') {
+        _rl_key_seq_state = KEY_SEQ_CSI_PARAM;
+        _key_seq_arg[0] = _key_seq_arg[1] = 0;
+        _key_seq_argc = 0;
+        _key_seq_ignored = 0;
+      } else if (ch == 'O') {
+        _rl_key_seq_state = KEY_SEQ_SS3_FINAL;
+      } else {
+        rl_key_seq_run(KEY_SEQ_ALT(ch));
+      }
+      break;
+
+    case KEY_SEQ_CSI_PARAM:
+      if (c >= '0' && c <= '9') {
+        if (_key_seq_argc < 2) {
+          unsigned int val = _key_seq_arg[_key_seq_argc] * 10U + (c - '0');
+          _key_seq_arg[_key_seq_argc] = (val > 255U ? 255U : val);
+        }
+      } else if (ch == ';') {
+        if (++_key_seq_argc >= 2) {
+          _key_seq_ignored = 1;
+          _key_seq_argc = 2;
+        }
+      } else if (c >= 0x40 && c <= 0x7E) {  // final byte
+        rl_key_seq_run(_key_seq_ignored ? 0 : KEY_SEQ_CSI(ch, _key_seq_arg[0], _key_seq_arg[1]));
+      } else {  // private parameters(<=>?) and intermediate bytes are not supported.
+        _key_seq_ignored = 1;
+      }
+      break;
+
+    case KEY_SEQ_SS3_FINAL:
+      rl_key_seq_run(KEY_SEQ_SS3(ch));
+      break;
+
+    default:
+      return 0;
+  }
+
+  return 1;
+}
+
+#endif /* CONFIG_SHELL_KEY_SEQ_BIND */
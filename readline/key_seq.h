@@ -1,7 +1,7 @@
 /**
  * @file key_seq.h
  * @author Liber (lvlebin@outlook.com)
- * @brief
+ * @brief ESC Control Sequence decoder and key binding.
  * @version 1.0
  * @date 2020-03-21
  *
@@ -14,11 +14,33 @@
 
 #include <stdint.h>
 
+#include "command/shell_linker.h"
+#include "shell_config.h"
+
 typedef uint32_t u32;
 typedef uint8_t u8;
 
-#define CONVERT_KEY_SEQ(c1, c2, c3, c4) \
-  ((u32)((((u8)(c1)) << 24) | (((u8)(c2)) << 16) | (((u8)(c3)) << 8) | (((u8)(c4)) << 0)))
+/**
+ * A key sequence is decoded into a 32-bit key code:
+ *
+ *   | 31..24 | 23..16 | 15..8 | 7..0 |
+ *   | intro  | final  | arg1  | arg2 |
+ *
+ * intro: '[' for CSI ("ESC [ arg1 ; arg2 final"), 'O' for SS3 ("ESC O final"),
+ *        ESC for "ESC final" (Alt + final).
+ * arg1, arg2: numeric parameters of CSI (0 if omitted, saturate at 255).
+ */
+#define KEY_SEQ(intro, final, arg1, arg2) \
+  ((u32)((((u8)(intro)) << 24) | (((u8)(final)) << 16) | (((u8)(arg1)) << 8) | (((u8)(arg2)) << 0)))
+
+// "ESC [ arg1 ; arg2 final", such as "ESC[A"(up arrow), "ESC[3~"(delete), "ESC[1;5C"(Ctrl-Right).
+#define KEY_SEQ_CSI(final, arg1, arg2) KEY_SEQ('[', final, arg1, arg2)
+
+// "ESC O final", such as "ESC OA"(up arrow in application cursor mode).
+#define KEY_SEQ_SS3(final) KEY_SEQ('O', final, 0, 0)
+
+// "ESC final", such as "ESC b"(Alt-B).
+#define KEY_SEQ_ALT(final) KEY_SEQ('\033', final, 0, 0)
 
 
 typedef struct {
@@ -27,7 +49,51 @@ typedef struct {
 } key_seq_t;
 
 
-void rl_dispatch_seq(char ch);
+/**
+ * @brief bind a key sequence to a function, the bindings added by this macro take precedence
+ * over the built-in ones.
+ *
+ * @_name: name of the binding. Note: THIS IS NOT a string.
+ * @_key: key code, built with KEY_SEQ_CSI(), KEY_SEQ_SS3() or KEY_SEQ_ALT().
+ * @_func: function pointer: void (*)(void), such as the readline functions below.
+ */
+#define NANO_SHELL_BIND_KEY(_name, _key, _func) \
+  _shell_entry_declare(key_seq_t, _name) = { (_key), (_func) }
+
+
+/**
+ * @brief feed `ch` to the key sequence decoder, the sequence starts with ESC.
+ *
+ * @return int 1: `ch` is consumed.
+ *             0: `ch` is a control character which aborts the sequence, dispatch it as a key.
+ */
+int rl_dispatch_seq(char ch);
+
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+// state of the key sequence decoder, every shell context has its own (see "nano_shell_ctx.h").
+typedef struct {
+  int state;   // non-zero means a sequence is in progress.
+  u8 arg[2];
+  u8 argc;     // index of the current parameter.
+  u8 ignored;  // non-zero means the sequence has unsupported parameters.
+} key_seq_ctx_t;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+
+// readline functions which can be bound to key sequences.
+extern void rl_get_pre_history(void);   // `up arrow` or `Ctrl P`
+extern void rl_get_next_history(void);  // `down arrow` or `Ctrl N`
+extern void rl_backward_cursor(void);   // `right arrow` or `Ctrl F`
+extern void rl_forward_cursor(void);    // `left arrow` or `Ctrl B`
+extern void rl_prev_word(void);         // `Ctrl left arrow` or `Alt B`
+extern void rl_next_word(void);         // `Ctrl right arrow` or `Alt F`
+extern void rl_line_home(void);         // `Home`
+extern void rl_line_end(void);          // `End`
+extern void rl_delete(void);            // `Delete`
+extern void rl_paste_begin(void);       // bracketed paste start: `ESC[200~`
+extern void rl_paste_end(void);         // bracketed paste end: `ESC[201~`
+extern void rl_redisplay(void);         // redisplay the prompt and the line on a new line.
 
 
 #endif /* __NANO_SHELL_KEY_SEQ_H */
@@ -18,13 +18,51 @@
 
 #include "shell_config.h"
 
+#if CONFIG_SHELL_TAB_COMPLETION
+#include "command/command.h"
+#include "parse/text_parse.h"
+#endif /* CONFIG_SHELL_TAB_COMPLETION */
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+#include "nano_shell_ctx.h"
+
+/**
+ * every shell context has its own readline state (`rl_ctx_t`), the file-scope variables below are
+ * not declared, their names refer to the fields of the current context instead.
+ */
+  #define _rl_line_buffer (nano_shell_ctx->rl.line_buffer)
+  #define _rl_done (nano_shell_ctx->rl.done)
+  #define _rl_end (nano_shell_ctx->rl.end)
+  #define _rl_cursor (nano_shell_ctx->rl.cursor)
+#if CONFIG_SHELL_MULTI_LINE
+  #define _rl_home (nano_shell_ctx->rl.home)
+#endif /* CONFIG_SHELL_MULTI_LINE */
+  #define _rl_paste (nano_shell_ctx->rl.paste)
+  #define _rl_prompt (nano_shell_ctx->rl.prompt)
+  #define _rl_searching (nano_shell_ctx->rl.searching)
+  #define _rl_search_pattern (nano_shell_ctx->rl.search_pattern)
+  #define _rl_search_len (nano_shell_ctx->rl.search_len)
+  #define _rl_search_match (nano_shell_ctx->rl.search_match)
+  #define _rl_search_cols (nano_shell_ctx->rl.search_cols)
+  #define _rl_comp_again (nano_shell_ctx->rl.comp_again)
+  #define _rl_comp_first (nano_shell_ctx->rl.comp_first)
+  #define _rl_comp_len (nano_shell_ctx->rl.comp_len)
+  #define _rl_key_seq_state (nano_shell_ctx->key_seq.state)
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
 
 #define CTL_CH(ch) ((ch) - 'A' + 1)
 #define U_SHELL_ALERT() shell_putc('\a')
 
+// non-zero means `ch` is added to the buffer as-is, instead of being dispatched as a key.
+#define RL_IS_TEXT(ch) ((ch) >= ' ' && (ch) != 127 && (ch) != (char)255)
+
+#if !CONFIG_SHELL_LINE_EDITING
 // erase sequence, used to erase one character on screen.
 static const char _erase_seq[] = "\b \b";
+#endif /* CONFIG_SHELL_LINE_EDITING */
 
+#if !CONFIG_SHELL_MULTI_INSTANCE
 // console input buffer
 static char _rl_line_buffer[CONFIG_SHELL_INPUT_BUFFSIZE + 1];
 
@@ -36,27 +74,287 @@ static int _rl_done;
  * 0 <= `_rl_end` <= `CONFIG_SHELL_INPUT_BUFFSIZE`
  * When `_rl_cursor` is at the end of the line, `_rl_cursor` and `_rl_end` are equal.
  * Note that the value of `_rl_line_buffer[_rl_end]` should be `\0` in any case.
+ * (except in gap buffer mode, see below.)
  */
 static int _rl_end;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
 
 
 #if CONFIG_SHELL_LINE_EDITING
+#if !CONFIG_SHELL_MULTI_INSTANCE
   // The offset of the current cursor position in `_rl_line_buffer`
   // 0 <= `_rl_cursor` <= `_rl_end`
   static int _rl_cursor;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+  #define _rl_point _rl_cursor
+#else
+  #define _rl_point _rl_end
 #endif /* CONFIG_SHELL_LINE_EDITING */
 
 
-#if CONFIG_SHELL_KEY_SEQ_BIND
-  /* uesed by @file{key_seq.c} to recognize key sequences */
-  int _rl_key_seq_len = 0;
+#if CONFIG_SHELL_GAP_BUFFER
+/**
+memory view of the input buffer in gap buffer mode:
+
+-------------------------------------------------------------------------------------
+| text before cursor |              gap               | text after cursor       |\0|
+-------------------------------------------------------------------------------------
+^                    ^                                ^                          ^
+&buffer[0]           _rl_cursor                       RL_TAIL()                  buffer[INPUT_BUFFSIZE]
+
+Inserting or deleting at the cursor doesn't move any text, only moving the cursor does.
+The gap is closed (the text after cursor is moved to `_rl_cursor`) when the line is completed.
+*/
+  #if !CONFIG_SHELL_LINE_EDITING
+    #error "CONFIG_SHELL_GAP_BUFFER requires CONFIG_SHELL_LINE_EDITING."
+  #endif
+
+  // text after cursor, terminated by '\0'.
+  #define RL_TAIL() (&_rl_line_buffer[CONFIG_SHELL_INPUT_BUFFSIZE - (_rl_end - _rl_cursor)])
+#elif CONFIG_SHELL_LINE_EDITING
+  #define RL_TAIL() (&_rl_line_buffer[_rl_cursor])
+#endif /* CONFIG_SHELL_GAP_BUFFER */
+
+
+#if CONFIG_SHELL_KEY_SEQ_BIND && !CONFIG_SHELL_MULTI_INSTANCE
+  /* state of the key sequence decoder in @file{key_seq.c}, non-zero means a sequence is in progress */
+  extern int _rl_key_seq_state;
+
+  // non-zero means the input is pasted text (between "ESC[200~" and "ESC[201~").
+  static int _rl_paste;
 #endif
 
+#if !CONFIG_SHELL_MULTI_INSTANCE
+// the prompt of current line, used to redisplay the line.
+static const char *_rl_prompt = CONFIG_SHELL_PROMPT;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+
+/******************************** buffer operations ********************************/
+
+#if CONFIG_SHELL_LINE_EDITING
+// insert `n` characters at the cursor, the caller MUST make sure the buffer has enough space.
+static void rl_buf_insert(const char *str, int n)
+{
+#if !CONFIG_SHELL_GAP_BUFFER
+  memmove(&_rl_line_buffer[_rl_cursor + n], &_rl_line_buffer[_rl_cursor], _rl_end - _rl_cursor + 1);
+#endif /* CONFIG_SHELL_GAP_BUFFER */
+  memcpy(&_rl_line_buffer[_rl_cursor], str, n);
+  _rl_cursor += n;
+  _rl_end += n;
+}
+
+// delete `n` characters before the cursor.
+static void rl_buf_delete_backward(int n)
+{
+#if !CONFIG_SHELL_GAP_BUFFER
+  memmove(&_rl_line_buffer[_rl_cursor - n], &_rl_line_buffer[_rl_cursor], _rl_end - _rl_cursor + 1);
+#endif /* CONFIG_SHELL_GAP_BUFFER */
+  _rl_cursor -= n;
+  _rl_end -= n;
+}
+
+// delete `n` characters after the cursor.
+static void rl_buf_delete_forward(int n)
+{
+#if !CONFIG_SHELL_GAP_BUFFER
+  memmove(&_rl_line_buffer[_rl_cursor], &_rl_line_buffer[_rl_cursor + n], _rl_end - _rl_cursor - n + 1);
+#endif /* CONFIG_SHELL_GAP_BUFFER */
+  _rl_end -= n;
+}
+
+// move the cursor to `pos` in the buffer (not on the screen).
+static void rl_buf_move_cursor(int pos)
+{
+#if CONFIG_SHELL_GAP_BUFFER
+  if (pos < _rl_cursor) {
+    memmove(RL_TAIL() - (_rl_cursor - pos), &_rl_line_buffer[pos], _rl_cursor - pos);
+  } else if (pos > _rl_cursor) {
+    memmove(&_rl_line_buffer[_rl_cursor], RL_TAIL(), pos - _rl_cursor);
+  }
+#endif /* CONFIG_SHELL_GAP_BUFFER */
+  _rl_cursor = pos;
+}
+#endif /* CONFIG_SHELL_LINE_EDITING */
+
+#if CONFIG_SHELL_MULTI_LINE
+// the last character of the line, the line MUST NOT be empty.
+static char rl_buf_last_char(void)
+{
+#if CONFIG_SHELL_GAP_BUFFER
+  if (_rl_end > _rl_cursor) {
+    return _rl_line_buffer[CONFIG_SHELL_INPUT_BUFFSIZE - 1];
+  }
+#endif /* CONFIG_SHELL_GAP_BUFFER */
+  return _rl_line_buffer[_rl_end - 1];
+}
+#endif /* CONFIG_SHELL_MULTI_LINE */
+
+
+/******************************** display operations ********************************/
+
+// send `n` characters of `str`.
+static void rl_put_text(const char *str, int n)
+{
+  if (n > 0) {
+    shell_write(str, (size_t)n);
+  }
+}
+
+// the cursor is moved only by the line editing and the history.
+#if CONFIG_SHELL_LINE_EDITING || CONFIG_SHELL_HIST_MIN_RECORD > 0
+#if CONFIG_SHELL_ANSI_CURSOR
+// length of the control sequence "ESC[<n><cmd>", the parameter is omitted if `n` is 1.
+static int rl_csi_len(int n)
+{
+  int len = 3;
+
+  if (n > 1) {
+    for (; n > 0; n /= 10) {
+      len++;
+    }
+  }
+  return len;
+}
+
+// send the control sequence "ESC[<n><cmd>".
+static void rl_put_csi(int n, char cmd)
+{
+  char seq[16];
+  int i = sizeof(seq);
+
+  seq[--i] = '\0';
+  seq[--i] = cmd;
+  if (n > 1) {
+    for (; n > 0; n /= 10) {
+      seq[--i] = '0' + n % 10;
+    }
+  }
+  seq[--i] = '[';
+  seq[--i] = '\033';
+
+  shell_puts(&seq[i]);
+}
+
+// the number of bytes sent by `rl_move_back(n)`.
+static int rl_move_back_len(int n)
+{
+  int len = rl_csi_len(n);
+  return (n < len ? n : len);
+}
+#else
+  #define rl_move_back_len(n) (n)
+#endif /* CONFIG_SHELL_ANSI_CURSOR */
+
+// move cursor left `n` columns on the screen.
+static void rl_move_back(int n)
+{
+#if CONFIG_SHELL_ANSI_CURSOR
+  if (n > rl_csi_len(n)) {
+    rl_put_csi(n, 'D');
+    return;
+  }
+#endif /* CONFIG_SHELL_ANSI_CURSOR */
+
+  while (n > 0) {
+    shell_putc('\b');
+    n--;
+  }
+}
+
+#if CONFIG_SHELL_LINE_EDITING
+// move cursor right `n` columns on the screen, over the text after cursor.
+static void rl_move_forward(int n)
+{
+#if CONFIG_SHELL_ANSI_CURSOR
+  if (n > rl_csi_len(n)) {
+    rl_put_csi(n, 'C');
+    return;
+  }
+#endif /* CONFIG_SHELL_ANSI_CURSOR */
+
+  rl_put_text(RL_TAIL(), n);
+}
+#endif /* CONFIG_SHELL_LINE_EDITING */
+
+// clear `n` columns after the cursor (there is nothing displayed after them), keep the cursor.
+static void rl_clear_columns(int n)
+{
+  if (n <= 0) {
+    return;
+  }
+
+#if CONFIG_SHELL_ANSI_CURSOR
+  if (n + rl_move_back_len(n) > 3) {
+    shell_puts("\033[K");
+    return;
+  }
+#endif /* CONFIG_SHELL_ANSI_CURSOR */
+
+  for (int i = 0; i < n; i++) {
+    shell_putc(' ');
+  }
+  rl_move_back(n);
+}
+#endif /* CONFIG_SHELL_LINE_EDITING || CONFIG_SHELL_HIST_MIN_RECORD > 0 */
+
+#if CONFIG_SHELL_LINE_EDITING
+/**
+ * redraw the text after cursor, and clear `erase` columns after it (the text has been deleted),
+ * then move the cursor back.
+ */
+static void rl_redraw_tail(int erase)
+{
+  int len = _rl_end - _rl_cursor;
+
+  if (len == 0) {
+    rl_clear_columns(erase);
+    return;
+  }
+
+#if CONFIG_SHELL_ANSI_CURSOR
+  if (erase > 0) {
+    // the deleted text is still displayed right after the cursor, the tail follows it.
+    rl_put_csi(erase, 'P');
+    return;
+  }
+#endif /* CONFIG_SHELL_ANSI_CURSOR */
+
+  shell_puts(RL_TAIL());
+  for (int i = 0; i < erase; i++) {
+    shell_putc(' ');
+  }
+  rl_move_back(len + erase);
+}
+
+// display `n` characters of `str` which have been inserted before the cursor.
+static void rl_show_insert(const char *str, int n)
+{
+#if CONFIG_SHELL_ANSI_CURSOR
+  int len = _rl_end - _rl_cursor;
+
+  if (len + rl_move_back_len(len) > rl_csi_len(n)) {  // cheaper than redrawing the tail.
+    rl_put_csi(n, '@');
+    rl_put_text(str, n);
+    return;
+  }
+#endif /* CONFIG_SHELL_ANSI_CURSOR */
+
+  rl_put_text(str, n);
+  if (_rl_cursor < _rl_end) {
+    rl_redraw_tail(0);
+  }
+}
+#endif /* CONFIG_SHELL_LINE_EDITING */
+
 
 void rl_end_input(void);
 
 #if CONFIG_SHELL_MULTI_LINE
+#if !CONFIG_SHELL_MULTI_INSTANCE
     static int _rl_home;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
 
   /**
    * @brief Judge whether the line should be continued
@@ -67,18 +365,19 @@ void rl_end_input(void);
   int rl_should_continue()
   {
     // in version 1.0, only judged whether the last character is '\' or not
-    return (_rl_end > _rl_home && _rl_line_buffer[_rl_end-1] == '\\');
+    return (_rl_end > _rl_home && rl_buf_last_char() == '\\');
   }
 
   void rl_new_line()
   {
     if (rl_should_continue()) {
-      _rl_line_buffer[--_rl_end] = '\0'; // overwrite the backslash('\')
-      _rl_home = _rl_end;
-
 #if CONFIG_SHELL_LINE_EDITING
-      _rl_cursor = _rl_end;  // update _rl_cursor if LINE_EDITING is enabled.
+      rl_buf_move_cursor(_rl_end);
+      rl_buf_delete_backward(1);  // overwrite the backslash('\')
+#else
+      _rl_line_buffer[--_rl_end] = '\0'; // overwrite the backslash('\')
 #endif /* CONFIG_SHELL_LINE_EDITING */
+      _rl_home = _rl_end;
 
       shell_puts("\r\n> ");
     } else {
@@ -93,6 +392,11 @@ void rl_end_input(void);
 
 void rl_end_input(void)
 {
+#if CONFIG_SHELL_GAP_BUFFER
+  rl_buf_move_cursor(_rl_end);  // close the gap.
+  _rl_line_buffer[_rl_end] = '\0';
+#endif /* CONFIG_SHELL_GAP_BUFFER */
+
 #if CONFIG_SHELL_HIST_MIN_RECORD > 0
   if (*_rl_line_buffer) {
     rl_history_add(_rl_line_buffer);
@@ -112,29 +416,46 @@ void rl_end_input(void)
   shell_puts("\r\n");
 }
 
-// add one character to the buffer
-void rl_add_char(char ch)
+// discard the whole line (include the previous lines of a multi-line input).
+void rl_kill_line(void)
 {
-  if (_rl_end < CONFIG_SHELL_INPUT_BUFFSIZE && ch >= ' ') {
 #if CONFIG_SHELL_LINE_EDITING
-    int len = _rl_end - _rl_cursor;
-
-    _rl_end++;
-    _rl_line_buffer[_rl_end] = '\0';
+  _rl_cursor = 0;
+#endif /* CONFIG_SHELL_LINE_EDITING */
+  _rl_end = 0;
+  *_rl_line_buffer = '\0';
+}
 
-    memmove(&_rl_line_buffer[_rl_cursor + 1], &_rl_line_buffer[_rl_cursor], len);
-    _rl_line_buffer[_rl_cursor] = ch;
+/**
+ * insert `n` printable characters at the cursor and display them at once,
+ * the characters which don't fit in the buffer are dropped.
+ */
+void rl_insert_text(const char *str, int n)
+{
+  if (n > (int)CONFIG_SHELL_INPUT_BUFFSIZE - _rl_end) {
+    n = CONFIG_SHELL_INPUT_BUFFSIZE - _rl_end;
+    U_SHELL_ALERT();
+  }
+  if (n <= 0) {
+    return;
+  }
 
-    shell_puts(&_rl_line_buffer[_rl_cursor++]);
-    while (len > 0) {
-      shell_putc('\b');
-      len--;
-    }
+#if CONFIG_SHELL_LINE_EDITING
+  rl_buf_insert(str, n);
+  rl_show_insert(str, n);
 #else
-    shell_putc(ch);
-    _rl_line_buffer[_rl_end++] = ch;
-    _rl_line_buffer[_rl_end] = '\0';
+  rl_put_text(str, n);
+  memcpy(&_rl_line_buffer[_rl_end], str, n);
+  _rl_end += n;
+  _rl_line_buffer[_rl_end] = '\0';
 #endif /* CONFIG_SHELL_LINE_EDITING */
+}
+
+// add one character to the buffer
+void rl_add_char(char ch)
+{
+  if (_rl_end < (int)CONFIG_SHELL_INPUT_BUFFSIZE && ch >= ' ') {
+    rl_insert_text(&ch, 1);
   } else {
     U_SHELL_ALERT();
   }
@@ -145,17 +466,9 @@ void rl_rubout(void)
 {
 #if CONFIG_SHELL_LINE_EDITING
   if (_rl_cursor > _rl_home) {
-    int len = _rl_end - (--_rl_cursor);
-    _rl_end--;
-
-    memmove(&_rl_line_buffer[_rl_cursor], &_rl_line_buffer[_rl_cursor + 1], len);
+    rl_buf_delete_backward(1);
     shell_putc('\b');
-    shell_puts(&_rl_line_buffer[_rl_cursor]);
-    shell_putc(' ');
-    do {
-      shell_putc('\b');
-      len--;
-    } while (len > 0);
+    rl_redraw_tail(1);
 #else
   if (_rl_end > _rl_home) {
     _rl_end--;
@@ -169,26 +482,38 @@ void rl_rubout(void)
 
 
 #if CONFIG_SHELL_HIST_MIN_RECORD > 0
-void rl_process_history(const char *history)
+// replace the text after `_rl_home` with `text` in the buffer (not on the screen), return the new length.
+static int rl_buf_replace(const char *text)
 {
-  if (history) {
-#if CONFIG_SHELL_LINE_EDITING
-    shell_puts(&_rl_line_buffer[_rl_cursor]);  // move cursor to the end on screen.
-#endif
+  int len = strlen(text);
 
-    while (_rl_end > _rl_home) {       // erase all on the screen.
-      shell_puts(_erase_seq);
-      _rl_end--;
-    }
+  if (len > (int)CONFIG_SHELL_INPUT_BUFFSIZE - _rl_home) {  // the previous lines take some space.
+    len = (int)CONFIG_SHELL_INPUT_BUFFSIZE - _rl_home;
+  }
 
-    _rl_end = strlen(history) + _rl_home;  // update _rl_end.
+  _rl_end = len + _rl_home;  // update _rl_end.
 
 #if CONFIG_SHELL_LINE_EDITING
-    _rl_cursor = _rl_end;       // update _rl_cursor if LINE_EDITING is enabled.
+  _rl_cursor = _rl_end;       // update _rl_cursor if LINE_EDITING is enabled.
 #endif
 
-    memcpy(_rl_line_buffer + _rl_home, history, _rl_end -_rl_home + 1);
-    shell_puts(_rl_line_buffer + _rl_home);  // display new text and move cursor to the end on screen.
+  memcpy(_rl_line_buffer + _rl_home, text, len);
+  _rl_line_buffer[_rl_end] = '\0';
+
+  return len;
+}
+
+void rl_process_history(const char *history)
+{
+  if (history) {
+    int old_len = _rl_end - _rl_home;
+    int len;
+
+    rl_move_back(_rl_point - _rl_home);  // move cursor to the beginning on screen.
+
+    len = rl_buf_replace(history);
+    rl_put_text(_rl_line_buffer + _rl_home, len);  // display new text and move cursor to the end on screen.
+    rl_clear_columns(old_len - len);               // clear the rest of the old text.
   } else {
     U_SHELL_ALERT();
   }
@@ -211,33 +536,56 @@ void rl_get_next_history(void)
 void rl_delete(void)
 {
   if (_rl_cursor < _rl_end) {
-    int len = _rl_end - _rl_cursor;
-    _rl_end--;
-
-    memmove(&_rl_line_buffer[_rl_cursor], &_rl_line_buffer[_rl_cursor + 1], len);
-    shell_puts(&_rl_line_buffer[_rl_cursor]);
-    shell_putc(' ');
-    do {
-      shell_putc('\b');
-      len--;
-    } while (len > 0);
+    rl_buf_delete_forward(1);
+    rl_redraw_tail(1);
   }
 }
 
 // Move curosr to the beginning of line.
 void rl_line_home(void)
 {
-  while (_rl_cursor > _rl_home) {
-    shell_putc('\b');
-    _rl_cursor--;
-  }
+  rl_move_back(_rl_cursor - _rl_home);
+  rl_buf_move_cursor(_rl_home);
 }
 
 // Move cursor to the end of line.
 void rl_line_end(void)
 {
-  shell_puts(_rl_line_buffer + _rl_cursor);
-  _rl_cursor = _rl_end;
+  rl_move_forward(_rl_end - _rl_cursor);
+  rl_buf_move_cursor(_rl_end);
+}
+
+// Move cursor to the beginning of the current or previous word.
+void rl_prev_word(void)
+{
+  int pos = _rl_cursor;
+
+  while (pos > _rl_home && _rl_line_buffer[pos - 1] == ' ') {
+    pos--;
+  }
+  while (pos > _rl_home && _rl_line_buffer[pos - 1] != ' ') {
+    pos--;
+  }
+
+  rl_move_back(_rl_cursor - pos);
+  rl_buf_move_cursor(pos);
+}
+
+// Move cursor to the end of the current or next word.
+void rl_next_word(void)
+{
+  const char *tail = RL_TAIL();
+  int n = 0;
+
+  while (tail[n] == ' ') {
+    n++;
+  }
+  while (tail[n] != '\0' && tail[n] != ' ') {
+    n++;
+  }
+
+  rl_move_forward(n);
+  rl_buf_move_cursor(_rl_cursor + n);
 }
 
 // Move forward (left).
@@ -245,7 +593,7 @@ void rl_forward_cursor(void)
 {
   if (_rl_cursor > _rl_home) {
     shell_putc('\b');
-    _rl_cursor--;
+    rl_buf_move_cursor(_rl_cursor - 1);
   } else {
     U_SHELL_ALERT();
   }
@@ -255,8 +603,8 @@ void rl_forward_cursor(void)
 void rl_backward_cursor(void)
 {
   if (_rl_cursor < _rl_end) {
-    shell_putc(_rl_line_buffer[_rl_cursor]);
-    _rl_cursor++;
+    shell_putc(*RL_TAIL());
+    rl_buf_move_cursor(_rl_cursor + 1);
   } else {
     U_SHELL_ALERT();
   }
@@ -266,57 +614,409 @@ void rl_backward_cursor(void)
 void rl_erase_all_backward(void)
 {
   if (_rl_cursor > _rl_home) {
-    int len = _rl_end - _rl_cursor + 1;
+    int len = _rl_cursor - _rl_home;
+
+    rl_move_back(len);  // move cursor to the beginning on screen.
+    rl_buf_delete_backward(len);
+    rl_redraw_tail(len);
+  }
+}
+
+// Erase from cursor to end of line.
+void rl_erase_all_forward(void)
+{
+  int len = _rl_end - _rl_cursor;
+
+  rl_buf_delete_forward(len);
+  rl_redraw_tail(len);
+}
+#endif /* CONFIG_SHELL_LINE_EDITING */
+
+
+#if CONFIG_SHELL_KEY_SEQ_BIND
+// Bracketed paste start, the terminal sends it only after "ESC[?2004h".
+void rl_paste_begin(void)
+{
+  _rl_paste = 1;
+}
+
+// Bracketed paste end.
+void rl_paste_end(void)
+{
+  _rl_paste = 0;
+}
+#endif /* CONFIG_SHELL_KEY_SEQ_BIND */
+
+
+// display the prompt of current line.
+static void rl_put_prompt(void)
+{
+  if (_rl_home > 0) {
+    shell_puts("> ");
+  } else if (_rl_prompt) {
+    shell_puts(_rl_prompt);
+  }
+}
+
+// Redisplay the prompt and current line on a new line, keep the cursor position.
+void rl_redisplay(void)
+{
+  rl_put_prompt();
+
+#if CONFIG_SHELL_LINE_EDITING
+  rl_put_text(_rl_line_buffer + _rl_home, _rl_cursor - _rl_home);
+  rl_redraw_tail(0);
+#else
+  shell_write(_rl_line_buffer + _rl_home, _rl_end - _rl_home);  // nothing after a completed line.
+#endif /* CONFIG_SHELL_LINE_EDITING */
+}
+
+
+#if CONFIG_SHELL_HIST_SEARCH
+
+#if CONFIG_SHELL_HIST_MIN_RECORD == 0
+  #error "CONFIG_SHELL_HIST_SEARCH requires CONFIG_SHELL_HIST_MIN_RECORD."
+#endif
+
+static const char _rl_search_prompt[] = "(reverse-i-search)`";
+
+#if !CONFIG_SHELL_MULTI_INSTANCE
+// non-zero means Ctrl-R search is in progress.
+static int _rl_searching;
+
+static char _rl_search_pattern[RL_SEARCH_PATTERN_SIZE + 1];
+static int _rl_search_len;
+
+// the matched record, NULL means nothing has been matched.
+static const char *_rl_search_match;
 
-    shell_puts(&_rl_line_buffer[_rl_cursor]);  // move cursor to the end on screen.
-    while (_rl_end > _rl_home) {                       // erase all on the screen
-      shell_puts(_erase_seq);
-      _rl_end--;
+// the number of columns of the line on the screen, the cursor is at the end of the line.
+static int _rl_search_cols;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+// the number of columns of the prompt of current line.
+static int rl_prompt_len(void)
+{
+  if (_rl_home > 0) {
+    return 2;
+  }
+  return (_rl_prompt ? strlen(_rl_prompt) : 0);
+}
+
+// redraw the search line: (reverse-i-search)`pattern': match
+static void rl_search_show(void)
+{
+  int cols = sizeof(_rl_search_prompt) - 1 + _rl_search_len + 3;
+
+  shell_putc('\r');
+  shell_puts(_rl_search_prompt);
+  rl_put_text(_rl_search_pattern, _rl_search_len);
+  shell_puts("': ");
+  if (_rl_search_match) {
+    shell_puts(_rl_search_match);
+    cols += strlen(_rl_search_match);
+  }
+
+  rl_clear_columns(_rl_search_cols - cols);
+  _rl_search_cols = cols;
+}
+
+// Reverse search history incrementally (Ctrl-R).
+static void rl_search_begin(void)
+{
+  _rl_searching = 1;
+  _rl_search_len = 0;
+  _rl_search_pattern[0] = '\0';
+  _rl_search_match = NULL;
+  _rl_search_cols = rl_prompt_len() + _rl_end - _rl_home;
+  rl_search_show();
+}
+
+/**
+ * end the search, put the matched record in the line if `accept` is non-zero,
+ * otherwise restore the line.
+ */
+static void rl_search_end(int accept)
+{
+  _rl_searching = 0;
+
+  if (accept && _rl_search_match) {
+    rl_buf_replace(_rl_search_match);
+  }
+
+  shell_putc('\r');
+  rl_put_prompt();
+  rl_put_text(_rl_line_buffer + _rl_home, _rl_point - _rl_home);
+#if CONFIG_SHELL_LINE_EDITING
+  shell_puts(RL_TAIL());
+#endif /* CONFIG_SHELL_LINE_EDITING */
+
+  rl_clear_columns(_rl_search_cols - (rl_prompt_len() + _rl_end - _rl_home));
+
+#if CONFIG_SHELL_LINE_EDITING
+  rl_move_back(_rl_end - _rl_cursor);
+#endif /* CONFIG_SHELL_LINE_EDITING */
+}
+
+/**
+ * react to `ch` in search mode, jump to the matched record directly.
+ *
+ * @return int 1: `ch` is consumed.
+ *             0: `ch` ends the search, dispatch it as usual.
+ */
+static int rl_search_dispatch(char ch)
+{
+  const char *match;
+
+  switch ((unsigned char)ch) {
+    case CTL_CH('R'):  // search the previous one.
+      match = rl_history_search(_rl_search_pattern, _rl_search_match != NULL);
+      if (match == NULL) {
+        U_SHELL_ALERT();
+        return 1;
+      }
+      _rl_search_match = match;
+      break;
+
+    case CTL_CH('G'):  // abort the search.
+      rl_search_end(0);
+      return 1;
+
+    case CTL_CH('C'):
+      rl_search_end(0);
+      return 0;
+
+    case 255:
+    case 127:
+    case 8:
+      if (_rl_search_len > 0) {
+        _rl_search_pattern[--_rl_search_len] = '\0';
+      } else {
+        U_SHELL_ALERT();
+      }
+      break;
+
+    default:
+      if (!RL_IS_TEXT(ch)) {  // accept the matched record.
+        rl_search_end(1);
+        return 0;
+      }
+      if (_rl_search_len >= RL_SEARCH_PATTERN_SIZE) {
+        U_SHELL_ALERT();
+        return 1;
+      }
+
+      _rl_search_pattern[_rl_search_len++] = ch;
+      _rl_search_pattern[_rl_search_len] = '\0';
+      match = rl_history_search(_rl_search_pattern, 0);
+      if (match) {
+        _rl_search_match = match;
+      } else {  // keep the pattern matched.
+        _rl_search_pattern[--_rl_search_len] = '\0';
+        U_SHELL_ALERT();
+        return 1;
+      }
+      break;
+  }
+
+  rl_search_show();
+  return 1;
+}
+#endif /* CONFIG_SHELL_HIST_SEARCH */
+
+
+#if CONFIG_SHELL_TAB_COMPLETION
+
+#if !CONFIG_SHELL_MULTI_INSTANCE
+// non-zero means the last key is a Tab which could not complete anything.
+static int _rl_comp_again;
+
+// the first candidate, and the length of the longest common prefix of all candidates.
+static const char *_rl_comp_first;
+static int _rl_comp_len;
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+static void rl_comp_common_prefix(const shell_cmd_t *pCmdt, void *arg)
+{
+  const char *name = pCmdt->name;
+
+  (void)arg;
+
+  if (_rl_comp_first == NULL) {
+    _rl_comp_first = name;
+    _rl_comp_len = strlen(name);
+  } else {
+    int i = 0;
+    while (i < _rl_comp_len && _rl_comp_first[i] == name[i]) {
+      i++;
     }
+    _rl_comp_len = i;
+  }
+}
+
+static void rl_comp_print(const shell_cmd_t *pCmdt, void *arg)
+{
+  (void)arg;
+  shell_printf("%s  ", pCmdt->name);
+}
+
+// put back the characters replaced by rl_comp_split().
+static void rl_comp_restore(char *const argv[], const char saved[], int argc)
+{
+  for (int i = 0; i < argc; i++) {
+    argv[i][strlen(argv[i])] = saved[i];
+  }
+}
+
+/**
+ * split the words before `end` in the line buffer in place, the same way as nano_shell_parse_line().
+ * `_rl_line_buffer[end]` MUST be a blank (or `end` is 0). Every word is terminated by replacing the
+ * character after it with '\0', which is saved in `saved` for rl_comp_restore().
+ *
+ * @return int: the number of words, -1 if there are too many words or a quote is not closed.
+ */
+static int rl_comp_split(int end, char *argv[], char saved[])
+{
+  char *input = _rl_line_buffer, *stop = &_rl_line_buffer[end];
+  int argc = 0;
 
-    memmove(_rl_line_buffer + _rl_home, &_rl_line_buffer[_rl_cursor], len--);  // new text.
-    shell_puts(_rl_line_buffer + _rl_home);  // display new text and move cursor to the end on screen.
+  for (;;) {
+    while (input < stop && (*input == ' ' || *input == '\t')) {
+      input++;
+    }
+    if (input >= stop) {
+      return argc;
+    }
+    if (argc >= (int)CONFIG_SHELL_CMD_MAX_ARGC) {
+      break;
+    }
 
-    _rl_cursor = _rl_home;
-    _rl_end = len + _rl_home;
-    while (len > 0) {  // move cursor to the begin on the screen.
-      shell_putc('\b');
-      len--;
+    if (*input == '"' || *input == '\'') {
+      char quote = *input++;
+      argv[argc] = input;
+      while (input < stop && *input != quote) {
+        input++;
+      }
+      if (input >= stop) {  // the word to be completed is in quotes.
+        break;
+      }
+    } else {
+      argv[argc] = input;
+      while (input < stop && *input != ' ' && *input != '\t') {
+        input++;
+      }
     }
+
+    saved[argc++] = *input;
+    *input++ = '\0';
   }
+
+  rl_comp_restore(argv, saved, argc);
+  return -1;
 }
 
-// Erase from cursor to end of line.
-void rl_erase_all_forward(void)
+// Complete the command (or sub-command) under the cursor (Tab), in place in the line buffer.
+void rl_complete(void)
 {
-  shell_puts(&_rl_line_buffer[_rl_cursor]);  // move cursor to the end on screen.
-  while (_rl_end > _rl_cursor) {
-    shell_puts(_erase_seq);  // erase all right to _rl_cursor, and move screen cursor to _rl_cursor.
-    _rl_end--;
+  char *argv[CONFIG_SHELL_CMD_MAX_ARGC + 1];
+  char saved[CONFIG_SHELL_CMD_MAX_ARGC + 1];
+  char *prefix, tail;
+  int argc, start = _rl_point, prefix_len, list;
+  unsigned int n;
+
+  // find the beginning of the word to be completed.
+  while (start > 0 && _rl_line_buffer[start - 1] != ' ' && _rl_line_buffer[start - 1] != '\t') {
+    start--;
+  }
+  prefix_len = _rl_point - start;
+
+  // split the words before it, and terminate the prefix at the cursor.
+  argc = rl_comp_split(start > 0 ? start - 1 : 0, argv, saved);
+  if (argc < 0) {
+    U_SHELL_ALERT();
+    return;
+  }
+  argv[argc] = NULL;
+  prefix = &_rl_line_buffer[start];
+  tail = _rl_line_buffer[_rl_point];  // in gap buffer mode, either the gap or the text after cursor.
+  _rl_line_buffer[_rl_point] = '\0';
+
+  _rl_comp_first = NULL;
+  n = shell_complete_cmd(argc, argv, prefix, rl_comp_common_prefix, NULL);
+
+  list = (n > 1 && _rl_comp_len <= prefix_len && _rl_comp_again);
+  if (list) {  // list the candidates.
+    shell_puts("\r\n");
+    shell_complete_cmd(argc, argv, prefix, rl_comp_print, NULL);
+    shell_puts("\r\n");
+  }
+
+  _rl_line_buffer[_rl_point] = tail;
+  rl_comp_restore(argv, saved, argc);
+
+  if (n == 0) {
+    U_SHELL_ALERT();
+  } else if (n == 1 || _rl_comp_len > prefix_len) {  // fill in the longest common prefix.
+    rl_insert_text(&_rl_comp_first[prefix_len], _rl_comp_len - prefix_len);
+    if (n == 1) {
+      rl_add_char(' ');
+    }
+    _rl_comp_again = (n > 1);
+  } else if (list) {
+    rl_redisplay();
+  } else {
+    _rl_comp_again = 1;
+    U_SHELL_ALERT();
   }
-  _rl_line_buffer[_rl_end] = '\0';
 }
-#endif /* CONFIG_SHELL_LINE_EDITING */
+#endif /* CONFIG_SHELL_TAB_COMPLETION */
 
 
 void rl_dispatch(char ch)
 {
 #if CONFIG_SHELL_KEY_SEQ_BIND
-  if (_rl_key_seq_len) {
-    rl_dispatch_seq(ch);
+  if (_rl_key_seq_state && rl_dispatch_seq(ch)) {
+    return;
+  }
+
+  if (_rl_paste && ch != '\033' && ch != '\r' && ch != '\n' && ch != CTL_CH('C')) {
+    // pasted text is inserted as-is: Tab becomes a space, other control characters are dropped.
+    if (ch == '\t') {
+      ch = ' ';
+    }
+    if (RL_IS_TEXT(ch)) {
+      rl_add_char(ch);
+    }
     return;
   }
 #endif /* CONFIG_SHELL_KEY_SEQ_BIND */
 
-  switch (ch) {
+#if CONFIG_SHELL_HIST_SEARCH
+  if (_rl_searching && rl_search_dispatch(ch)) {
+    return;
+  }
+#endif /* CONFIG_SHELL_HIST_SEARCH */
+
+#if CONFIG_SHELL_TAB_COMPLETION
+  if (ch == '\t') {
+    rl_complete();
+    return;
+  }
+  _rl_comp_again = 0;
+#endif /* CONFIG_SHELL_TAB_COMPLETION */
+
+  switch ((unsigned char)ch) {
     case '\r':  // CTL_CH('M')
     case '\n':  // CTL_CH('J')
       rl_new_line();
       break;
 
     case CTL_CH('C'):
+#if CONFIG_SHELL_KEY_SEQ_BIND
+      _rl_paste = 0;
+#endif /* CONFIG_SHELL_KEY_SEQ_BIND */
       shell_puts("^C\r\n");
-      *_rl_line_buffer = '\0';
+      rl_kill_line();
       rl_end_input();
       break;
 
@@ -373,6 +1073,11 @@ void rl_dispatch(char ch)
     case CTL_CH('N'):  // down arrow
       rl_get_next_history();
       break;
+#if CONFIG_SHELL_HIST_SEARCH
+    case CTL_CH('R'):  // reverse search
+      rl_search_begin();
+      break;
+#endif /* CONFIG_SHELL_HIST_SEARCH */
 #endif /* CONFIG_SHELL_HIST_MIN_RECORD > 0 */
 
     default:  // add current character to the buffer
@@ -386,6 +1091,7 @@ char *readline(const char *promot)
 {
   char input;
 
+  _rl_prompt = promot;
   if (promot) {
     shell_puts(promot);
   }
@@ -397,6 +1103,17 @@ char *readline(const char *promot)
   // start read the new line.
   while (_rl_done == 0) {
     while (!shell_getc(&input)) {
+#if CONFIG_SHELL_TX_BUFFER_SIZE > 0
+      shell_flush();  // show the echo before waiting for the next input.
+#endif /* CONFIG_SHELL_TX_BUFFER_SIZE > 0 */
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0 && CONFIG_SHELL_HIST_STORE
+      rl_history_poll();
+#endif /* CONFIG_SHELL_HIST_STORE */
+#if CONFIG_SHELL_INPUT_WAIT
+      if (!shell_wait_input(CONFIG_SHELL_IDLE_PERIOD)) {
+        shell_idle();
+      }
+#endif /* CONFIG_SHELL_INPUT_WAIT */
     }
 
     rl_dispatch(input);
@@ -417,3 +1134,54 @@ char *readline_react(char ch)
 
   return (_rl_done ? _rl_line_buffer : NULL);
 }
+
+
+char *readline_react_buf(const char *buf, size_t len, size_t *used)
+{
+  size_t i = 0, n;
+
+  if (_rl_done) { // clean last line.
+    _rl_done = 0;
+    *_rl_line_buffer = '\0';
+  }
+
+  while (i < len && _rl_done == 0) {
+    // find the run of printable characters, unless a key sequence is in progress.
+    n = i;
+#if CONFIG_SHELL_KEY_SEQ_BIND
+    if (_rl_key_seq_state == 0)
+#endif /* CONFIG_SHELL_KEY_SEQ_BIND */
+#if CONFIG_SHELL_HIST_SEARCH
+    if (_rl_searching == 0)
+#endif /* CONFIG_SHELL_HIST_SEARCH */
+    {
+      while (n < len && RL_IS_TEXT(buf[n])) {
+        n++;
+      }
+    }
+
+    if (n > i) {  // insert the whole run at once.
+#if CONFIG_SHELL_TAB_COMPLETION
+      _rl_comp_again = 0;
+#endif /* CONFIG_SHELL_TAB_COMPLETION */
+      rl_insert_text(&buf[i], n - i);
+      i = n;
+    } else {
+      rl_dispatch(buf[i++]);
+    }
+  }
+
+  if (used) {
+    *used = i;
+  }
+
+  return (_rl_done ? _rl_line_buffer : NULL);
+}
+
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+void rl_ctx_init(rl_ctx_t *rl)
+{
+  rl->prompt = CONFIG_SHELL_PROMPT;
+}
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
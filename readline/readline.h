@@ -12,6 +12,10 @@
 #ifndef __NANO_SHELL_READLINE_H
 #define __NANO_SHELL_READLINE_H
 
+#include <stddef.h>
+
+#include "shell_config.h"
+
 
 // read a line of input. Prompt with PROMPT. A NULL PROMPT means none.
 char *readline(const char *promot);
@@ -27,4 +31,66 @@ char *readline(const char *promot);
 char *readline_react(char ch);
 
 
+/**
+ * @brief react to `len` input characters in `buf` (e.g. pasted text), stop after a line is completed.
+ * runs of printable characters are inserted and displayed at once.
+ *
+ * @param[in] buf: input characters.
+ * @param[in] len: the number of characters in `buf`.
+ * @param[out] used: the number of characters consumed, can be NULL.
+ * @return: the completed line, NULL means all `len` characters are consumed and the current line
+ *          has not been completed (need more input).
+ *
+ */
+char *readline_react_buf(const char *buf, size_t len, size_t *used);
+
+
+#if CONFIG_SHELL_HIST_SEARCH
+// max length of the Ctrl-R search pattern.
+#define RL_SEARCH_PATTERN_SIZE 32
+#endif /* CONFIG_SHELL_HIST_SEARCH */
+
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+/**
+ * @brief state of readline, every shell context has its own (see "nano_shell_ctx.h").
+ *        the fields are the file-scope variables of the single instance build, see @file{readline.c}.
+ */
+typedef struct {
+  char line_buffer[CONFIG_SHELL_INPUT_BUFFSIZE + 1];
+  int done;
+  int end;
+#if CONFIG_SHELL_LINE_EDITING
+  int cursor;
+#endif /* CONFIG_SHELL_LINE_EDITING */
+#if CONFIG_SHELL_MULTI_LINE
+  int home;
+#endif /* CONFIG_SHELL_MULTI_LINE */
+#if CONFIG_SHELL_KEY_SEQ_BIND
+  int paste;
+#endif /* CONFIG_SHELL_KEY_SEQ_BIND */
+  const char *prompt;
+#if CONFIG_SHELL_HIST_SEARCH
+  int searching;
+  char search_pattern[RL_SEARCH_PATTERN_SIZE + 1];
+  int search_len;
+  const char *search_match;
+  int search_cols;
+#endif /* CONFIG_SHELL_HIST_SEARCH */
+#if CONFIG_SHELL_TAB_COMPLETION
+  int comp_again;
+  const char *comp_first;
+  int comp_len;
+#endif /* CONFIG_SHELL_TAB_COMPLETION */
+} rl_ctx_t;
+
+
+/**
+ * @brief initialize the readline state `rl` (which has been zeroed).
+ *
+ */
+void rl_ctx_init(rl_ctx_t *rl);
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+
 #endif /* __NANO_SHELL_READLINE_H */
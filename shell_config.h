@@ -20,45 +20,265 @@
 /* set 1 to enable command line edit */
 #define CONFIG_SHELL_LINE_EDITING 1
 
+/**
+ * set 1 to use a gap buffer for line editing, requires CONFIG_SHELL_LINE_EDITING.
+ * inserting or deleting in the middle of the line doesn't move the text after the cursor,
+ *   recommended for large CONFIG_SHELL_INPUT_BUFFSIZE.
+ */
+#define CONFIG_SHELL_GAP_BUFFER 0
+
+/**
+ * set 1 to move the cursor and erase/insert/delete characters on the screen with ANSI control
+ *   sequences (ESC[nD, ESC[nC, ESC[K, ESC[n@, ESC[nP) whenever they are shorter than the plain
+ *   backspaces and redraws. set 0 for dumb terminals which only understand '\b'.
+ */
+#define CONFIG_SHELL_ANSI_CURSOR 1
+
 /* ESC Control Sequence detect, such as Home, Delete, Arrow, etc. */
 #define CONFIG_SHELL_KEY_SEQ_BIND 1
 
+/**
+ * max number of bindings added by NANO_SHELL_BIND_KEY() in a static index sorted by key code,
+ *   set 0 to disable the index. nano-shell will take `CONFIG_SHELL_KEY_SEQ_BIND_INDEX*sizeof(void *)`
+ *   bytes for it, and find the bindings with binary search. With more bindings, they are scanned linearly.
+ */
+#define CONFIG_SHELL_KEY_SEQ_BIND_INDEX (8U)
+
 /* set 1 to enable Backslash('\') for line continuation */
 #define CONFIG_SHELL_MULTI_LINE 1
 
+/**
+ * set 1 to enable Tab completion of commands and sub-commands.
+ * press Tab twice to list the candidates.
+ * sub-commands can be completed only if CONFIG_SHELL_CMD_PATH_RESOLVE is enabled.
+ */
+#define CONFIG_SHELL_TAB_COMPLETION 0
+
 
 /**
  * set 0 to disable history record.
  *
- * nano-shell will take `CONFIG_SHELL_HIST_MIN_RECORD*(2+CONFIG_SHELL_INPUT_BUFFSIZE)` bytes to
+ * nano-shell will take `(CONFIG_SHELL_HIST_MIN_RECORD+1)*(5+CONFIG_SHELL_INPUT_BUFFSIZE)` bytes to
  *   record **at least** `CONFIG_SHELL_HIST_MIN_RECORD` histroys.
- * the maximum number of history records depends on the average length of the input.
+ * the maximum number of history records depends on the average length of the input,
+ *   a line shorter than 127 characters takes its length plus 3 bytes.
  */
 #define CONFIG_SHELL_HIST_MIN_RECORD (5U)
 
+/**
+ * set 1 to save only the characters which are not shared with the next history record (plus one
+ * length byte), consecutive identical lines are saved once. more records fit in the same buffer
+ * when the lines are similar.
+ */
+#define CONFIG_SHELL_HIST_DELTA 0
+
+/**
+ * set 1 to enable incremental reverse search of history (Ctrl-R), requires CONFIG_SHELL_HIST_MIN_RECORD.
+ */
+#define CONFIG_SHELL_HIST_SEARCH 0
+
+/**
+ * set 1 to save a 32-bit signature of the characters with every history record (4 bytes per record),
+ * the search skips the records which can't contain the pattern without comparing them.
+ * requires CONFIG_SHELL_HIST_SEARCH.
+ */
+#define CONFIG_SHELL_HIST_SEARCH_FILTER 0
+
+/**
+ * set 1 to save the history to a persistent storage (flash, eeprom, file, ...) and restore it at
+ *   startup, requires CONFIG_SHELL_HIST_MIN_RECORD.
+ * the records are appended to a log through `history_store_write/read/erase()` (see "history.h"),
+ *   the log is erased and rewritten with the newest records when it is full.
+ */
+#define CONFIG_SHELL_HIST_STORE 0
+
+/* size of the log in the storage (byte), must be no less than 2*(CONFIG_SHELL_INPUT_BUFFSIZE+1) */
+#define CONFIG_SHELL_HIST_STORE_SIZE (4096U)
+
+/**
+ * the new records are collected in a buffer of this size (byte) and written to the storage at once
+ *   when the buffer is full, CONFIG_SHELL_HIST_STORE_DELAY ms after the last record, or when
+ *   `rl_history_flush()` is called (by the default `shell_idle()`).
+ */
+#define CONFIG_SHELL_HIST_STORE_BATCH (64U)
+
+/**
+ * the batch is written when no record has been added for this many milliseconds, checked by
+ *   `readline()` while waiting for input and by `nano_shell_poll()` (call it in <interrupt mode>).
+ *   requires `shell_tick_ms()` (see "shell_io/shell_io.h"). 0: written at the next check.
+ */
+#define CONFIG_SHELL_HIST_STORE_DELAY (1000U)
+
+/**
+ * set 1 to build the storage functions on a POSIX file (for host builds),
+ *   the path of the file is CONFIG_SHELL_HIST_STORE_PATH.
+ */
+#define CONFIG_SHELL_HIST_STORE_POSIX 0
+#define CONFIG_SHELL_HIST_STORE_PATH ".nano_shell_history"
+
 
 /******************************* command configuration ****************************/
 
 #define CONFIG_SHELL_FUNC_BRIEF_USAGE 1
 
+/**
+ * set 1 to enable the built-in `call` command, which calls the functions added by
+ *   NANO_SHELL_ADD_FUNC() with numeric (or string) arguments.
+ */
+#define CONFIG_SHELL_FUNC_CALL 0
+
 #define CONFIG_SHELL_CMD_BRIEF_USAGE  1
 
 #define CONFIG_SHELL_CMD_LONG_HELP 1
 
+/**
+ * set 1 to enable declarative argument specifications (NANO_SHELL_ADD_CMD_ARGS()) and the shared
+ *   argument parser shell_parse_args(). `shell_cmd_t` will take one more pointer.
+ */
+#define CONFIG_SHELL_CMD_ARG_SPEC 0
+
 /* nano-shell provides a built-in help command, set 0 to disable it */
 #define CONFIG_SHELL_CMD_BUILTIN_HELP 1
 
 /* config the max number of arguments, must be no less than 1. */
 #define CONFIG_SHELL_CMD_MAX_ARGC (10U)
 
+/**
+ * set 1 to look up top-level commands with binary search.
+ *
+ * the linker script recommended in README.md (`KEEP (*(SORT(.nano_shell*)))`) already sorts
+ *   the command table by name. nano-shell checks this once at the first lookup, and falls back
+ *   to the sorted index below (or to a linear scan) if the table is not sorted.
+ */
+#define CONFIG_SHELL_CMD_FAST_LOOKUP 1
+
+/**
+ * max number of commands in the static lookup index, set 0 to disable the index.
+ *
+ * only used when CONFIG_SHELL_CMD_FAST_LOOKUP is enabled and the command table is NOT sorted by
+ *   the linker, nano-shell will then take `CONFIG_SHELL_CMD_LOOKUP_INDEX*sizeof(void *)` bytes
+ *   to keep a sorted index of the command table, built once at the first lookup.
+ */
+#define CONFIG_SHELL_CMD_LOOKUP_INDEX (0U)
+
+/**
+ * set 1 to resolve a whole command path (such as `net if eth0 stats`) in a single walk.
+ *
+ * every group of sub-commands is registered in the nano_shell section (about 20 bytes of flash
+ *   per group), and nano-shell descends the groups in one loop instead of calling
+ *   NANO_SHELL_SUBCMDS_FCT() level by level.
+ */
+#define CONFIG_SHELL_CMD_PATH_RESOLVE 0
+
+/**
+ * max number of groups of sub-commands in the static group index, set 0 to disable the index.
+ *
+ * only used when CONFIG_SHELL_CMD_PATH_RESOLVE is enabled, nano-shell will then take
+ *   `CONFIG_SHELL_CMD_GROUP_INDEX*sizeof(void *)` bytes to keep the groups sorted by the address of
+ *   their function, built once at the first lookup. every level of a command path is then found with
+ *   binary search instead of a linear scan of all the groups.
+ */
+#define CONFIG_SHELL_CMD_GROUP_INDEX (16U)
+
+/* set 1 to accept unique prefixes of commands, such as `net i e s`. requires CONFIG_SHELL_CMD_PATH_RESOLVE */
+#define CONFIG_SHELL_CMD_ABBREV 0
+
+/**
+ * set 1 to enable resumable commands (NANO_SHELL_ADD_TASK_CMD()), which run step by step from
+ *   `nano_shell_poll()` while the shell keeps processing the input, and can be cancelled by Ctrl-C.
+ */
+#define CONFIG_SHELL_CMD_TASK 0
+
+/* size of the state kept by a resumable command across the steps (byte) */
+#define CONFIG_SHELL_CMD_TASK_STATE_SIZE (32U)
+
+/**
+ * set 1 to enable the built-in `watch` command, which runs a command periodically and redraws its
+ *   output in place, requires `shell_tick_ms()` (see "shell_io/shell_io.h").
+ * every job takes about `CONFIG_SHELL_WATCH_ARGS_SIZE+(CONFIG_SHELL_CMD_MAX_ARGC+5)*4` bytes.
+ */
+#define CONFIG_SHELL_CMD_WATCH 0
+
+/* max number of `watch` jobs */
+#define CONFIG_SHELL_WATCH_JOBS (2U)
+
+/* size of the arguments kept by a `watch` job (byte) */
+#define CONFIG_SHELL_WATCH_ARGS_SIZE (64U)
+
+/**
+ * max number of top-level commands with execution statistics (calls, cycles, output), and the
+ *   built-in `time` and `cmdstats` commands. set 0 to disable them.
+ * nano-shell will take `CONFIG_SHELL_CMD_STATS*24` bytes, the time is counted by
+ *   `shell_cycle_counter()` (see "shell_io/shell_io.h").
+ */
+#define CONFIG_SHELL_CMD_STATS (0U)
+
 
 /******************************* shell io configuration ****************************/
 
-/* config the buffer size (shell_printf()) */
+/**
+ * set 1 to use the built-in formatter of `shell_printf()`, the output is sent while parsing the
+ *   format, without an intermediate buffer and length limit (%d %i %u %x %X %o %s %c %p %%, flags,
+ *   width, precision and the length modifiers, %f %e %g %a print `?`). set 0 to use `vsnprintf()`
+ *   of libc (for %f, etc.).
+ */
+#define CONFIG_SHELL_PRINTF_BUILTIN 1
+
+/* config the buffer size (shell_printf()), only used when CONFIG_SHELL_PRINTF_BUILTIN is disabled */
 #define CONFIG_SHELL_PRINTF_BUFFER_SIZE 128U
 
+/**
+ * set 1 if your project implements `low_level_write(buf, len)` to send a block of characters (DMA,
+ *   socket, ...), instead of `low_level_write_char()`. see "shell_io/shell_io.c".
+ */
+#define CONFIG_SHELL_LOW_LEVEL_WRITE 0
+
+/**
+ * size of the transmit buffer (byte), set 0 to disable it.
+ * the output is collected in the buffer and sent at once when the buffer is full, before waiting for
+ *   input, at the end of `nano_shell_react()` or when `shell_flush()` is called.
+ */
+#define CONFIG_SHELL_TX_BUFFER_SIZE (0U)
+
+/**
+ * size of the transmit queue (byte), MUST be 0 (disabled) or a power of 2. requires C11 atomics,
+ *   not supported with CONFIG_SHELL_MULTI_INSTANCE.
+ * the output is queued and sent by the transmit interrupt of your port (or by `nano_shell_flush()`),
+ *   the commands don't wait for the console. see `shell_tx_start()` in "shell_io/shell_io.h".
+ */
+#define CONFIG_SHELL_TX_QUEUE_SIZE (0U)
+
+/**
+ * what to do when the transmit queue is full:
+ *   0: wait until there is room.
+ *   1: drop the output, the number of dropped characters is returned by `shell_tx_dropped()`.
+ *   2: call `shell_tx_yield()` and try again.
+ */
+#define CONFIG_SHELL_TX_QUEUE_FULL 0
+
+/**
+ * set 1 to sleep in `shell_wait_input()` while waiting for input in main loop mode, instead of
+ *   spinning on `shell_getc()`. `shell_idle()` is called every CONFIG_SHELL_IDLE_PERIOD
+ *   milliseconds without input.
+ */
+#define CONFIG_SHELL_INPUT_WAIT 0
+#define CONFIG_SHELL_IDLE_PERIOD (1000U)
+
+/**
+ * set 1 to build the I/O functions on stdin/stdout with a reader thread (for host builds),
+ *   `shell_wait_input()` waits on a condition variable. requires CONFIG_SHELL_INPUT_WAIT.
+ */
+#define CONFIG_SHELL_IO_POSIX 0
+
 
 /*******************************  shell configuration  ****************************/
 #define CONFIG_SHELL_PROMPT "Nano-Shell >> "
 
+/**
+ * set 1 to serve several consoles at the same time, every console has its own shell context
+ *   (`nano_shell_ctx_t` in "nano_shell_ctx.h"): input buffer, history, I/O functions, etc.
+ * set 0 to keep all the states in file-scope variables (one console only).
+ */
+#define CONFIG_SHELL_MULTI_INSTANCE 0
+
 #endif /* __NANO_SHELL_CONFIG_H */
@@ -11,10 +11,62 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "shell_io.h"
 #include "shell_config.h"
+#include "nano_shell.h"
+#include "readline/history.h"
+#include "static_fifo.h"
 
+#if CONFIG_SHELL_MULTI_INSTANCE
+// send the character to the console of the current shell context.
+#define low_level_write_char(ch) nano_shell_ctx->io->write_char(ch)
+
+#if CONFIG_SHELL_LOW_LEVEL_WRITE
+// send the block to the console of the current shell context, character by character if the console
+// has no `write()`.
+static void low_level_write(const char *buf, size_t len)
+{
+  if (nano_shell_ctx->io->write) {
+    nano_shell_ctx->io->write(buf, len);
+    return;
+  }
+  while (len--) {
+    low_level_write_char(*buf++);
+  }
+}
+#endif /* CONFIG_SHELL_LOW_LEVEL_WRITE */
+
+#if CONFIG_SHELL_TX_BUFFER_SIZE > 0
+#define shell_tx_buffer (nano_shell_ctx->tx_buffer)
+#define shell_tx_len (nano_shell_ctx->tx_len)
+#endif /* CONFIG_SHELL_TX_BUFFER_SIZE > 0 */
+
+#if CONFIG_SHELL_CMD_STATS > 0
+#define shell_tx_count (nano_shell_ctx->tx_count)
+#endif /* CONFIG_SHELL_CMD_STATS > 0 */
+
+#else
+
+#if CONFIG_SHELL_LOW_LEVEL_WRITE
+/**
+ * @brief This function should do the actual transmission of a block of characters, for example
+ *        start a DMA transfer (after the previous one is done), or `write()` to a socket.
+ *        `low_level_write_char()` is not used if CONFIG_SHELL_LOW_LEVEL_WRITE is enabled.
+ *
+ * @param buf the characters to be transmitted.
+ * @param len the number of characters in `buf`, greater than 0.
+ */
+extern void low_level_write(const char *buf, size_t len);
+
+#define low_level_write_char(ch) \
+  do {                           \
+    char _ch = (ch);             \
+    low_level_write(&_ch, 1);    \
+  } while (0)
+#else
 /**
  * @brief This function should do the actual transmission of the character.
  *        It can also be implemented by macro definition, for example:
@@ -28,6 +80,18 @@
  * @param ch the character to be transmitted.
  */
 extern void low_level_write_char(char ch);
+#endif /* CONFIG_SHELL_LOW_LEVEL_WRITE */
+
+#if CONFIG_SHELL_TX_BUFFER_SIZE > 0
+static char shell_tx_buffer[CONFIG_SHELL_TX_BUFFER_SIZE];
+static size_t shell_tx_len;
+#endif /* CONFIG_SHELL_TX_BUFFER_SIZE > 0 */
+
+#if CONFIG_SHELL_CMD_STATS > 0
+static unsigned long shell_tx_count;
+#endif /* CONFIG_SHELL_CMD_STATS > 0 */
+
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
 
 
 #if defined(__GNUC__)
@@ -39,6 +103,573 @@ extern void low_level_write_char(char ch);
 
 /****************************************************************/
 
+// send `len` characters of `buf` to the console through the low level functions.
+static void shell_low_level_send(const char *buf, size_t len)
+{
+#if CONFIG_SHELL_LOW_LEVEL_WRITE
+  low_level_write(buf, len);
+#else
+  while (len--) {
+    low_level_write_char(*buf++);
+  }
+#endif /* CONFIG_SHELL_LOW_LEVEL_WRITE */
+}
+
+
+#if CONFIG_SHELL_TX_QUEUE_SIZE > 0
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+#error "CONFIG_SHELL_TX_QUEUE_SIZE is not supported with CONFIG_SHELL_MULTI_INSTANCE."
+#endif
+
+#if (CONFIG_SHELL_TX_QUEUE_SIZE) & ((CONFIG_SHELL_TX_QUEUE_SIZE) - 1)
+#error "the value of CONFIG_SHELL_TX_QUEUE_SIZE must be a power of 2!"
+#endif
+
+#if !(defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__))
+#error "CONFIG_SHELL_TX_QUEUE_SIZE requires C11 atomics."
+#endif
+
+/**
+ * the output queue: nano-shell is the producer, the transmit interrupt of the port (or
+ *   `nano_shell_flush()`) is the consumer.
+ */
+static_spsc_fifo_declare(shell_tx_queue, CONFIG_SHELL_TX_QUEUE_SIZE, unsigned int, char);
+
+static size_t shell_tx_peak;
+
+#if CONFIG_SHELL_TX_QUEUE_FULL == 1
+static unsigned long shell_tx_drop_count;
+#endif /* CONFIG_SHELL_TX_QUEUE_FULL == 1 */
+
+
+__weak void shell_tx_start(void)
+{
+  nano_shell_flush();
+}
+
+
+#if CONFIG_SHELL_TX_QUEUE_FULL == 2
+__weak void shell_tx_yield(void)
+{
+}
+#endif /* CONFIG_SHELL_TX_QUEUE_FULL == 2 */
+
+
+void nano_shell_flush(void)
+{
+  const char *span;
+  size_t len;
+
+  while ((span = spsc_fifo_read_span(shell_tx_queue, &len), len > 0)) {
+    shell_low_level_send(span, len);
+    spsc_fifo_consume(shell_tx_queue, len);
+  }
+}
+
+
+int shell_tx_getc(char *ch)
+{
+  return spsc_fifo_pop(shell_tx_queue, ch);
+}
+
+
+const char *shell_tx_read_span(size_t *len)
+{
+  return spsc_fifo_read_span(shell_tx_queue, len);
+}
+
+
+void shell_tx_consume(size_t len)
+{
+  spsc_fifo_consume(shell_tx_queue, len);
+}
+
+
+size_t shell_tx_pending(void)
+{
+  return spsc_fifo_size(shell_tx_queue);
+}
+
+
+size_t shell_tx_high_water(void)
+{
+  return shell_tx_peak;
+}
+
+
+#if CONFIG_SHELL_TX_QUEUE_FULL == 1
+unsigned long shell_tx_dropped(void)
+{
+  return shell_tx_drop_count;
+}
+#endif /* CONFIG_SHELL_TX_QUEUE_FULL == 1 */
+
+
+// add `len` characters of `buf` to the output queue, see CONFIG_SHELL_TX_QUEUE_FULL if it is full.
+static void shell_transmit(const char *buf, size_t len)
+{
+  size_t n;
+
+  for (;;) {
+    n = spsc_fifo_push_n(shell_tx_queue, buf, len);
+    buf += n;
+    len -= n;
+
+    n = spsc_fifo_size(shell_tx_queue);
+    if (n > shell_tx_peak) {
+      shell_tx_peak = n;
+    }
+    shell_tx_start();
+
+    if (len == 0) {
+      return;
+    }
+
+#if CONFIG_SHELL_TX_QUEUE_FULL == 1
+    shell_tx_drop_count += len;
+    return;
+#elif CONFIG_SHELL_TX_QUEUE_FULL == 2
+    shell_tx_yield();
+#endif /* CONFIG_SHELL_TX_QUEUE_FULL */
+  }
+}
+
+#else
+
+#define shell_transmit(buf, len) shell_low_level_send(buf, len)
+
+#endif /* CONFIG_SHELL_TX_QUEUE_SIZE > 0 */
+
+
+#if CONFIG_SHELL_CMD_STATS > 0
+unsigned long shell_output_count(void)
+{
+  return shell_tx_count;
+}
+
+// count the characters sent by `shell_write()` and `shell_send_char()`, for the command statistics.
+#define shell_count_output(n) (shell_tx_count += (n))
+#else
+#define shell_count_output(n) ((void)0)
+#endif /* CONFIG_SHELL_CMD_STATS > 0 */
+
+
+#if CONFIG_SHELL_TX_BUFFER_SIZE > 0
+
+void shell_flush(void)
+{
+  if (shell_tx_len) {
+    shell_transmit(shell_tx_buffer, shell_tx_len);
+    shell_tx_len = 0;
+  }
+}
+
+
+static void shell_send_char(char ch)
+{
+  shell_count_output(1);
+  if (shell_tx_len == CONFIG_SHELL_TX_BUFFER_SIZE) {
+    shell_flush();
+  }
+  shell_tx_buffer[shell_tx_len++] = ch;
+}
+
+
+__weak void shell_write(const char *buf, size_t len)
+{
+  size_t n;
+
+  shell_count_output(len);
+  while (len > 0) {
+    if (shell_tx_len == 0 && len >= CONFIG_SHELL_TX_BUFFER_SIZE) {
+      shell_transmit(buf, len);  // nothing to coalesce with, send it directly.
+      return;
+    }
+
+    n = CONFIG_SHELL_TX_BUFFER_SIZE - shell_tx_len;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(&shell_tx_buffer[shell_tx_len], buf, n);
+    shell_tx_len += n;
+    buf += n;
+    len -= n;
+
+    if (shell_tx_len == CONFIG_SHELL_TX_BUFFER_SIZE) {
+      shell_flush();
+    }
+  }
+}
+
+#else
+
+void shell_flush(void)
+{
+}
+
+
+#if CONFIG_SHELL_TX_QUEUE_SIZE > 0
+static void shell_send_char(char ch)
+{
+  shell_count_output(1);
+  shell_transmit(&ch, 1);
+}
+#else
+#define shell_send_char(ch)     \
+  do {                          \
+    shell_count_output(1);      \
+    low_level_write_char(ch);   \
+  } while (0)
+#endif /* CONFIG_SHELL_TX_QUEUE_SIZE > 0 */
+
+
+__weak void shell_write(const char *buf, size_t len)
+{
+  shell_count_output(len);
+  if (len > 0) {
+    shell_transmit(buf, len);
+  }
+}
+
+#endif /* CONFIG_SHELL_TX_BUFFER_SIZE > 0 */
+
+
+#if CONFIG_SHELL_PRINTF_BUILTIN
+
+// send `ch` `count` times.
+static void shell_fill(char ch, int count)
+{
+  while (count-- > 0) {
+    shell_send_char(ch);
+  }
+}
+
+
+/**
+ * @brief convert `value` to digits in `base` (8, 10 or 16), backward from `end`.
+ *        the `unsigned long` conversion is kept apart, so 64-bit division is used only by `%ll`.
+ *
+ * @return the first digit.
+ */
+static char *shell_ultoa(char *end, unsigned long value, unsigned int base, const char *digits)
+{
+  if (base == 10) {
+    do {
+      *--end = (char)('0' + value % 10);
+      value /= 10;
+    } while (value);
+  } else {
+    unsigned int shift = (base == 16) ? 4 : 3;
+    do {
+      *--end = digits[value & (base - 1)];
+      value >>= shift;
+    } while (value);
+  }
+  return end;
+}
+
+
+static char *shell_ulltoa(char *end, unsigned long long value, unsigned int base, const char *digits)
+{
+  while (value > (unsigned long)-1) {
+    *--end = digits[value % base];
+    value /= base;
+  }
+  return shell_ultoa(end, (unsigned long)value, base, digits);
+}
+
+
+/**
+ * @brief send a converted field: `prefix` (sign or "0x"), `zeros` zeros (the precision of an integer)
+ *        and `len` characters of `str`, padded to `width` with spaces (on the left, or on the right
+ *        if `left`) or with zeros after the prefix.
+ *
+ * @return number of characters sent.
+ */
+static int shell_field(const char *prefix, int zeros, const char *str, int len, int width, int left, char pad)
+{
+  int prefix_len = 0;
+
+  while (prefix[prefix_len]) {
+    prefix_len++;
+  }
+
+  width -= prefix_len + zeros + len;
+  if (width > 0 && !left && pad == ' ') {
+    shell_fill(' ', width);
+  }
+  shell_write(prefix, prefix_len);
+  if (width > 0 && !left && pad == '0') {
+    shell_fill('0', width);
+  }
+  shell_fill('0', zeros);
+  shell_write(str, len);
+  if (width > 0 && left) {
+    shell_fill(' ', width);
+  }
+
+  return prefix_len + zeros + len + (width > 0 ? width : 0);
+}
+
+
+/**
+ * @brief send the digits `str`..`end` of an integer with `prefix`, applying the precision
+ *        (the minimum number of digits, `0` prints no digit for the value 0) and the `#` flag of `%o`.
+ *
+ * @return number of characters sent.
+ */
+static int shell_int_field(const char *prefix, const char *str, const char *end, int precision, int alt_octal,
+                           int width, int left, char pad)
+{
+  int len = (int)(end - str);
+  int zeros = 0;
+
+  if (precision >= 0) {
+    pad = ' ';  // the `0` flag is ignored if a precision is given
+    if (precision == 0 && len == 1 && *str == '0') {
+      len = 0;
+    }
+    if (precision > len) {
+      zeros = precision - len;
+    }
+  }
+  if (alt_octal && zeros == 0 && (len == 0 || *str != '0')) {
+    zeros = 1;  // `%#o` starts with a zero
+  }
+
+  return shell_field(prefix, zeros, str, len, width, left, pad);
+}
+
+
+/**
+ * @brief the formatter of `shell_printf()`, sends the output directly while parsing the format.
+ *
+ * supported: flags `-` `0` `+` ` ` `#`, width and precision (`*` too), length modifiers
+ *   `hh` `h` `l` `ll` `z` `t` `j` `L`, conversions `%d %i %u %x %X %o %s %c %p %%`.
+ *   floating point conversions (`%f %F %e %E %g %G %a %A`) are not supported: their argument is
+ *   skipped and `?` is sent instead. an unknown conversion is sent as it is.
+ *
+ * @return number of characters sent.
+ */
+static int shell_vprintf(const char *format, va_list ap)
+{
+  static const char lower_digits[] = "0123456789abcdef";
+  static const char upper_digits[] = "0123456789ABCDEF";
+
+  char digits[(sizeof(unsigned long long) * 8 + 2) / 3];  // enough for octal
+  char *end = digits + sizeof(digits);
+  const char *str;
+  const char *prefix;
+  int count = 0;
+  int len, width, precision, left, alt, size;
+  char pad, sign;
+
+  while (*format) {
+    // send the literal text up to the next conversion at once.
+    for (str = format; *format && *format != '%'; format++) {
+    }
+    if (format != str) {
+      len = (int)(format - str);
+      shell_write(str, len);
+      count += len;
+      continue;
+    }
+
+    format++;  // skip '%'
+
+    left = 0;
+    alt = 0;
+    pad = ' ';
+    sign = 0;
+    for (;; format++) {
+      if (*format == '-') {
+        left = 1;
+      } else if (*format == '#') {
+        alt = 1;
+      } else if (*format == '0') {
+        pad = '0';
+      } else if (*format == '+' || (*format == ' ' && !sign)) {
+        sign = *format;
+      } else {
+        break;
+      }
+    }
+
+    width = 0;
+    if (*format == '*') {
+      width = va_arg(ap, int);
+      if (width < 0) {
+        left = 1;
+        width = -width;
+      }
+      format++;
+    } else {
+      while (*format >= '0' && *format <= '9') {
+        width = width * 10 + (*format++ - '0');
+      }
+    }
+
+    precision = -1;
+    if (*format == '.') {
+      format++;
+      precision = 0;
+      if (*format == '*') {
+        precision = va_arg(ap, int);
+        format++;
+      } else {
+        while (*format >= '0' && *format <= '9') {
+          precision = precision * 10 + (*format++ - '0');
+        }
+      }
+    }
+
+    // -2: char, -1: short, 0: int, 1: long, 2: long long, 3: long double
+    size = 0;
+    for (;; format++) {
+      if (*format == 'l') {
+        size++;
+      } else if (*format == 'h') {
+        size--;
+      } else if (*format == 'z' || *format == 't') {
+        size = (sizeof(size_t) > sizeof(long)) ? 2 : (sizeof(size_t) > sizeof(int));
+      } else if (*format == 'j') {
+        size = 2;
+      } else if (*format == 'L') {
+        size = 3;
+      } else {
+        break;
+      }
+    }
+
+    if (left) {
+      pad = ' ';
+    }
+
+    prefix = "";
+    switch (*format) {
+    case 'd':
+    case 'i': {
+      long long value = (size >= 2) ? va_arg(ap, long long)
+                        : (size == 1) ? va_arg(ap, long) : va_arg(ap, int);  // char and short are promoted to int
+      if (size < 0) {
+        value = (size == -1) ? (short)value : (signed char)value;
+      }
+      unsigned long long magnitude = (value < 0) ? 0 - (unsigned long long)value : (unsigned long long)value;
+
+      if (value < 0) {
+        prefix = "-";
+      } else if (sign) {
+        prefix = (sign == '+') ? "+" : " ";
+      }
+      str = (size >= 2) ? shell_ulltoa(end, magnitude, 10, lower_digits)
+                        : shell_ultoa(end, (unsigned long)magnitude, 10, lower_digits);
+      count += shell_int_field(prefix, str, end, precision, 0, width, left, pad);
+      break;
+    }
+
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'p': {
+      const char *table = (*format == 'X') ? upper_digits : lower_digits;
+      unsigned int base = (*format == 'u') ? 10 : (*format == 'o') ? 8 : 16;
+
+      if (*format == 'p') {
+        prefix = "0x";
+        size = (sizeof(void *) > sizeof(long)) ? 2 : 1;
+      }
+      if (size >= 2) {
+        unsigned long long value = (*format == 'p') ? (unsigned long long)(uintptr_t)va_arg(ap, void *)
+                                                    : va_arg(ap, unsigned long long);
+        str = shell_ulltoa(end, value, base, table);
+      } else {
+        unsigned long value = (*format == 'p') ? (unsigned long)(uintptr_t)va_arg(ap, void *)
+                              : (size == 1) ? va_arg(ap, unsigned long) : va_arg(ap, unsigned int);
+        if (size < 0) {
+          value = (size == -1) ? (unsigned short)value : (unsigned char)value;
+        }
+        str = shell_ultoa(end, value, base, table);
+      }
+      if (alt && base == 16 && *format != 'p' && !(end - str == 1 && *str == '0')) {
+        prefix = (*format == 'X') ? "0X" : "0x";
+      }
+      count += shell_int_field(prefix, str, end, precision, alt && base == 8, width, left, pad);
+      break;
+    }
+
+    case 'c':
+      digits[0] = (char)va_arg(ap, int);
+      count += shell_field("", 0, digits, 1, width, left, ' ');
+      break;
+
+    case 's':
+      str = va_arg(ap, const char *);
+      if (!str) {
+        str = "(null)";
+      }
+      for (len = 0; str[len] && (precision < 0 || len < precision); len++) {
+      }
+      count += shell_field("", 0, str, len, width, left, ' ');
+      break;
+
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':  // not supported, but the argument must be consumed to keep the next ones in place.
+      if (size == 3) {
+        (void)va_arg(ap, long double);
+      } else {
+        (void)va_arg(ap, double);
+      }
+      count += shell_field("", 0, "?", 1, width, left, ' ');
+      break;
+
+    case '%':
+      shell_send_char('%');
+      count++;
+      break;
+
+    default:  // unknown conversion, send it as it is.
+      shell_send_char('%');
+      count++;
+      if (*format) {
+        shell_send_char(*format);
+        count++;
+      }
+      break;
+    }
+
+    if (*format) {
+      format++;
+    }
+  }
+
+  return count;
+}
+
+
+__weak int shell_printf(const char *format, ...)
+{
+  int length = 0;
+
+  va_list ap;
+  va_start(ap, format);
+
+  length = shell_vprintf(format, ap);
+
+  va_end(ap);
+
+  return length;
+}
+
+#else
+
 #if !(CONFIG_SHELL_PRINTF_BUFFER_SIZE > 0)
 #error "the value of CONFIG_SHELL_PRINTF_BUFFER_SIZE must be greater than 0!"
 #endif
@@ -46,7 +677,11 @@ extern void low_level_write_char(char ch);
 
 __weak int shell_printf(const char *format, ...)
 {
+#if CONFIG_SHELL_MULTI_INSTANCE
+  char *shell_printf_buffer = nano_shell_ctx->printf_buffer;
+#else
   static char shell_printf_buffer[CONFIG_SHELL_PRINTF_BUFFER_SIZE];
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
 
   int length = 0;
 
@@ -57,24 +692,75 @@ __weak int shell_printf(const char *format, ...)
 
   va_end(ap);
 
-  for (int i = 0; i < length; i++) {
-    low_level_write_char(shell_printf_buffer[i]);
+  if (length > 0) {  // the output longer than the buffer is truncated.
+    shell_write(shell_printf_buffer, ((size_t)length < CONFIG_SHELL_PRINTF_BUFFER_SIZE) ? (size_t)length
+                                                                                        : CONFIG_SHELL_PRINTF_BUFFER_SIZE - 1);
   }
 
   return length;
 }
+#endif /* CONFIG_SHELL_PRINTF_BUILTIN */
 
 
 __weak void shell_puts(const char *str)
 {
-  while (*str) {
-    low_level_write_char(*str);
-    str++;
-  }
+  shell_write(str, strlen(str));
 }
 
 
 __weak void shell_putc(char ch)
 {
-  low_level_write_char(ch);
+  shell_send_char(ch);
+}
+
+
+#if CONFIG_SHELL_MULTI_INSTANCE
+__weak int shell_getc(char *ch)
+{
+  return nano_shell_ctx->io->read_char(ch);
+}
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+
+
+#if CONFIG_SHELL_INPUT_WAIT
+__weak int shell_wait_input(unsigned int timeout)
+{
+#if CONFIG_SHELL_MULTI_INSTANCE
+  if (nano_shell_ctx->io->wait_input) {
+    return nano_shell_ctx->io->wait_input(timeout);
+  }
+#endif /* CONFIG_SHELL_MULTI_INSTANCE */
+  (void)timeout;
+  return 1;
+}
+
+
+__weak void shell_idle(void)
+{
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0 && CONFIG_SHELL_HIST_STORE
+  rl_history_flush();
+#endif /* CONFIG_SHELL_HIST_STORE */
+}
+#endif /* CONFIG_SHELL_INPUT_WAIT */
+
+
+#if CONFIG_SHELL_CMD_STATS > 0
+__weak unsigned long shell_cycle_counter(void)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+  // DWT->CYCCNT, the counter is enabled at the first call.
+  static volatile uint32_t *const DEMCR = (volatile uint32_t *)0xE000EDFCUL;
+  static volatile uint32_t *const DWT_CTRL = (volatile uint32_t *)0xE0001000UL;
+  static volatile uint32_t *const DWT_CYCCNT = (volatile uint32_t *)0xE0001004UL;
+
+  if (!(*DWT_CTRL & 1U)) {
+    *DEMCR |= (1UL << 24);  // TRCENA
+    *DWT_CYCCNT = 0;
+    *DWT_CTRL |= 1U;        // CYCCNTENA
+  }
+  return *DWT_CYCCNT;
+#else
+  return 0;  // no counter: only the calls and the output are counted.
+#endif
 }
+#endif /* CONFIG_SHELL_CMD_STATS > 0 */
@@ -12,6 +12,7 @@
 #ifndef __NANO_SHELL_IO_H
 #define __NANO_SHELL_IO_H
 
+#include <stddef.h>
 
 /*********************************************************************
    nano-shell uses these functions to get/send character from/to stream.
@@ -32,6 +33,23 @@ extern void shell_putc(char ch);
 extern void shell_puts(const char *str);
 
 
+/**
+ * @brief send `len` characters of `buf`.
+ *
+ */
+extern void shell_write(const char *buf, size_t len);
+
+
+/**
+ * @brief send the output collected in the transmit buffer (CONFIG_SHELL_TX_BUFFER_SIZE) at once.
+ *        nano-shell calls it before waiting for input and at the end of `nano_shell_react()`,
+ *        call it in a long running command to show the output so far. does nothing if the buffer
+ *        is disabled.
+ *
+ */
+extern void shell_flush(void);
+
+
 /**
  * @brief printf() for nano-shell
  *
@@ -66,4 +84,178 @@ extern int shell_printf(const char *format, ...) __attribute__((format(printf, 1
 extern int shell_getc(char *ch);
 
 
+#include "shell_config.h"
+
+#if CONFIG_SHELL_INPUT_WAIT
+/**
+ * @brief Sleep until there may be a character for `shell_getc()`, or `timeout` milliseconds have
+ *        elapsed. used by `readline()` instead of spinning on `shell_getc()`.
+ *        not used in <interrupt mode>.
+ *
+ * @param timeout max time to wait (ms).
+ * @return Result is non-zero if a character may be available, or 0 if timed out.
+ *
+ * @note the default (weak) implementation returns 1 at once (busy-spin). take a uart with a receive
+ * fifo for example, it may be like this:
+ *
+ * int shell_wait_input(unsigned int timeout)
+ * {
+ *   // the semaphore is given by the uart receive interrupt after pushing a character to the fifo.
+ *   return xSemaphoreTake(uart_rx_sem, pdMS_TO_TICKS(timeout)) == pdTRUE;
+ * }
+ *
+ * without os, `__WFI()` (sleep until the next interrupt) and `return 1;` also works.
+ */
+extern int shell_wait_input(unsigned int timeout);
+
+
+/**
+ * @brief Called by `readline()` when no input arrived in CONFIG_SHELL_IDLE_PERIOD milliseconds,
+ *        for periodic housekeeping. the default (weak) implementation writes the pending history
+ *        records to the storage (if CONFIG_SHELL_HIST_STORE is enabled).
+ *
+ */
+extern void shell_idle(void);
+#endif /* CONFIG_SHELL_INPUT_WAIT */
+
+
+#if CONFIG_SHELL_IO_POSIX
+/**
+ * @brief Called by `shell_wait_input()` of the POSIX port when stdin is closed and all the input
+ *        has been read. the default (weak) implementation writes the pending history records
+ *        and the output, then ENDS THE HOST PROCESS with `exit(0)`.
+ *        override it to leave the shell another way (such as `pthread_exit()`, or `longjmp()` back
+ *        to the caller of `nano_shell_loop()`). if it returns, it is not called again and
+ *        `shell_wait_input()` only times out from then on.
+ *
+ */
+extern void shell_posix_eof(void);
+#endif /* CONFIG_SHELL_IO_POSIX */
+
+
+#if CONFIG_SHELL_CMD_WATCH || (CONFIG_SHELL_HIST_STORE && CONFIG_SHELL_HIST_STORE_DELAY > 0)
+/**
+ * @brief a free running millisecond counter, used by the built-in `watch` command to schedule the
+ *        jobs and by the persistent history to delay the writes. it may wrap around. take a 1ms SysTick for example:
+ *
+ * unsigned long shell_tick_ms(void)
+ * {
+ *   return HAL_GetTick();
+ * }
+ *
+ */
+extern unsigned long shell_tick_ms(void);
+#endif /* CONFIG_SHELL_CMD_WATCH || CONFIG_SHELL_HIST_STORE_DELAY */
+
+
+#if CONFIG_SHELL_CMD_STATS > 0
+/**
+ * @brief a free running cycle counter, used to measure the commands (`time`, `cmdstats`).
+ *        it may wrap around, and can count in any unit (such as ns on a host).
+ *        the default (weak) implementation reads DWT->CYCCNT on Cortex-M3/M4/M7/M33, and returns 0
+ *        (no timing) on other targets.
+ *
+ */
+extern unsigned long shell_cycle_counter(void);
+
+
+/**
+ * @brief the number of characters sent to the console so far (by `shell_write()`, `shell_putc()`,
+ *        `shell_printf()`, etc.). it may wrap around.
+ *
+ */
+extern unsigned long shell_output_count(void);
+#endif /* CONFIG_SHELL_CMD_STATS > 0 */
+
+
+#if CONFIG_SHELL_TX_QUEUE_SIZE > 0
+/*********************************************************************
+   transmit queue (CONFIG_SHELL_TX_QUEUE_SIZE): the output is queued, and drained by the transmit
+   interrupt (or DMA) of your port, or by `nano_shell_flush()`.
+ *********************************************************************/
+
+/**
+ * @brief Called after the output is queued. the default (weak) implementation sends the whole queue
+ *        at once by `nano_shell_flush()` (the output is synchronous as without the queue).
+ *
+ * @note to send the output asynchronously, enable the transmit interrupt here, and drain the queue
+ * in the interrupt handler, for example:
+ *
+ * void shell_tx_start(void)
+ * {
+ *   USART1->CR1 |= USART_CR1_TXEIE;
+ * }
+ *
+ * void USART1_IRQHandler(void)
+ * {
+ *   char ch;
+ *   if (USART1->SR & USART_SR_TXE) {
+ *     if (shell_tx_getc(&ch)) {
+ *       USART1->DR = ch;
+ *     } else {
+ *       USART1->CR1 &= ~USART_CR1_TXEIE;  // the queue is empty.
+ *     }
+ *   }
+ * }
+ *
+ * or make it empty and call `nano_shell_flush()` from another task or timer. the queue has only one
+ * consumer: don't mix the interrupt and `nano_shell_flush()`.
+ */
+extern void shell_tx_start(void);
+
+
+#if CONFIG_SHELL_TX_QUEUE_FULL == 2
+/**
+ * @brief Called while the queue is full, before trying again. the default (weak) implementation does
+ *        nothing (busy wait), you may yield the cpu, such as `taskYIELD()`.
+ *
+ */
+extern void shell_tx_yield(void);
+#endif /* CONFIG_SHELL_TX_QUEUE_FULL == 2 */
+
+
+/**
+ * @brief consumer side: remove the first character of the queue and return it in `ch`.
+ *
+ * @return Result is non-zero if there was a character, or 0 if the queue is empty.
+ */
+extern int shell_tx_getc(char *ch);
+
+
+/**
+ * @brief consumer side: get the contiguous characters at the front of the queue, such as for a DMA
+ *        transfer, then remove them by `shell_tx_consume()` when they are sent.
+ *
+ * @param len return the number of characters at the returned pointer, 0 if the queue is empty.
+ */
+extern const char *shell_tx_read_span(size_t *len);
+extern void shell_tx_consume(size_t len);
+
+
+/**
+ * @brief the number of characters waiting in the queue. a command with bulk output can wait
+ *        while it is above some level, instead of filling the queue.
+ *
+ */
+extern size_t shell_tx_pending(void);
+
+
+/**
+ * @brief the maximum number of characters ever waiting in the queue (high-water mark), helps to
+ *        choose CONFIG_SHELL_TX_QUEUE_SIZE.
+ *
+ */
+extern size_t shell_tx_high_water(void);
+
+
+#if CONFIG_SHELL_TX_QUEUE_FULL == 1
+/**
+ * @brief the number of characters dropped because the queue was full.
+ *
+ */
+extern unsigned long shell_tx_dropped(void);
+#endif /* CONFIG_SHELL_TX_QUEUE_FULL == 1 */
+#endif /* CONFIG_SHELL_TX_QUEUE_SIZE > 0 */
+
+
 #endif /* __NANO_SHELL_IO_H */
@@ -0,0 +1,232 @@
+/**
+ * @file shell_io_posix.c
+ * @author Liber (lvlebin@outlook.com)
+ * @brief Implementation of the functions in file "shell_io.h" on stdin/stdout, for host builds.
+ * @version 1.0
+ * @date 2020-03-24
+ *
+ * @copyright Copyright (c) Liber 2020
+ *
+ */
+
+#include "shell_config.h"
+
+#if CONFIG_SHELL_IO_POSIX
+
+#if !CONFIG_SHELL_INPUT_WAIT
+#error "CONFIG_SHELL_IO_POSIX requires CONFIG_SHELL_INPUT_WAIT."
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shell_io.h"
+#include "static_fifo.h"
+#include "readline/history.h"
+
+#if defined(__GNUC__)
+#ifndef __weak
+#define __weak __attribute__((weak))
+#endif /* __weak */
+#endif /* __GNUC__ */
+
+/**
+ * a reader thread reads stdin directly into the receive fifo, and wakes up `shell_wait_input()`.
+ * when stdin is closed, `shell_posix_eof()` is called once the fifo is empty.
+ * the fifo itself is lock-free, the mutex only guards the condition variables.
+ */
+static_spsc_fifo_declare(posix_rx, 256, unsigned short, char);
+
+static pthread_mutex_t posix_rx_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t posix_rx_ready = PTHREAD_COND_INITIALIZER;  // the fifo is not empty
+static pthread_cond_t posix_rx_space = PTHREAD_COND_INITIALIZER;  // the fifo is not full
+static int posix_rx_eof;
+static int posix_rx_eof_handled;  // `shell_posix_eof()` has returned, don't call it again.
+
+static struct termios posix_termios;
+
+
+static void *posix_rx_thread(void *arg)
+{
+  char *span;
+  size_t len;
+  ssize_t n;
+
+  (void)arg;
+
+  for (;;) {
+    span = spsc_fifo_write_span(posix_rx, &len);
+    if (len == 0) {  // wait until `shell_getc()` makes room.
+      pthread_mutex_lock(&posix_rx_lock);
+      while ((span = spsc_fifo_write_span(posix_rx, &len), len == 0)) {
+        pthread_cond_wait(&posix_rx_space, &posix_rx_lock);
+      }
+      pthread_mutex_unlock(&posix_rx_lock);
+    }
+
+    n = read(STDIN_FILENO, span, len);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+
+    pthread_mutex_lock(&posix_rx_lock);
+    if (n <= 0) {
+      posix_rx_eof = 1;
+    } else {
+      spsc_fifo_commit(posix_rx, (size_t)n);
+    }
+    pthread_cond_broadcast(&posix_rx_ready);
+    pthread_mutex_unlock(&posix_rx_lock);
+
+    if (n <= 0) {
+      return NULL;
+    }
+  }
+}
+
+
+static void posix_restore_terminal(void)
+{
+  tcsetattr(STDIN_FILENO, TCSANOW, &posix_termios);
+}
+
+
+// put the terminal in raw mode (nano-shell echoes the input itself), and start the reader thread.
+static void posix_io_init(void)
+{
+  pthread_t thread;
+
+  if (tcgetattr(STDIN_FILENO, &posix_termios) == 0) {
+    struct termios raw = posix_termios;
+
+    raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+    raw.c_iflag &= ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    atexit(posix_restore_terminal);
+  }
+
+  pthread_create(&thread, NULL, posix_rx_thread, NULL);
+  pthread_detach(thread);
+}
+
+static pthread_once_t posix_io_once = PTHREAD_ONCE_INIT;
+
+
+#if CONFIG_SHELL_LOW_LEVEL_WRITE
+void low_level_write(const char *buf, size_t len)
+{
+  ssize_t n;
+
+  while (len > 0) {
+    n = write(STDOUT_FILENO, buf, len);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return;
+    }
+    buf += n;
+    len -= (size_t)n;
+  }
+}
+#else
+void low_level_write_char(char ch)
+{
+  putchar(ch);
+}
+#endif /* CONFIG_SHELL_LOW_LEVEL_WRITE */
+
+
+int shell_getc(char *ch)
+{
+  pthread_once(&posix_io_once, posix_io_init);
+
+  if (!spsc_fifo_pop(posix_rx, ch)) {
+    return 0;
+  }
+
+  if (spsc_fifo_size(posix_rx) + 1 == get_fifo_capacity(posix_rx)) {  // it was full, wake up the reader.
+    pthread_mutex_lock(&posix_rx_lock);
+    pthread_cond_signal(&posix_rx_space);
+    pthread_mutex_unlock(&posix_rx_lock);
+  }
+
+  return 1;
+}
+
+
+#if CONFIG_SHELL_CMD_WATCH || (CONFIG_SHELL_HIST_STORE && CONFIG_SHELL_HIST_STORE_DELAY > 0)
+unsigned long shell_tick_ms(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long)now.tv_sec * 1000UL + (unsigned long)(now.tv_nsec / 1000000L);
+}
+#endif /* CONFIG_SHELL_CMD_WATCH || CONFIG_SHELL_HIST_STORE_DELAY */
+
+
+#if CONFIG_SHELL_CMD_STATS > 0
+unsigned long shell_cycle_counter(void)  // in ns.
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long)now.tv_sec * 1000000000UL + (unsigned long)now.tv_nsec;
+}
+#endif /* CONFIG_SHELL_CMD_STATS > 0 */
+
+
+__weak void shell_posix_eof(void)
+{
+#if CONFIG_SHELL_HIST_MIN_RECORD > 0 && CONFIG_SHELL_HIST_STORE
+  rl_history_flush();
+#endif /* CONFIG_SHELL_HIST_STORE */
+  shell_flush();
+  fflush(stdout);
+  exit(0);
+}
+
+
+int shell_wait_input(unsigned int timeout)
+{
+  struct timespec deadline;
+  int ret, eof;
+
+  pthread_once(&posix_io_once, posix_io_init);
+  fflush(stdout);  // show everything before sleeping.
+
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout / 1000;
+  deadline.tv_nsec += (long)(timeout % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  pthread_mutex_lock(&posix_rx_lock);
+  while (spsc_is_fifo_empty(posix_rx) && !(posix_rx_eof && !posix_rx_eof_handled)) {
+    if (pthread_cond_timedwait(&posix_rx_ready, &posix_rx_lock, &deadline) == ETIMEDOUT) {
+      break;
+    }
+  }
+  ret = !spsc_is_fifo_empty(posix_rx);
+  eof = (!ret && posix_rx_eof && !posix_rx_eof_handled);
+  pthread_mutex_unlock(&posix_rx_lock);
+
+  if (eof) {  // stdin is closed and everything has been read.
+    shell_posix_eof();
+    posix_rx_eof_handled = 1;
+  }
+
+  return ret;
+}
+
+#endif /* CONFIG_SHELL_IO_POSIX */
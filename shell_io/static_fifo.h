@@ -1,5 +1,5 @@
 /**
- * @file fifo.h
+ * @file static_fifo.h
  * @author Liber (lvlebin@outlook.com)
  * @brief simple fifo based on ring buffer
  * @version 1.0
@@ -101,4 +101,235 @@
   (is_fifo_empty(name) ? 0 : _fifo_##name.buff[_fifo_##name.tail++ & _fifo_size_##name])
 
 
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief: declare a STATIC single-producer/single-consumer fifo for C11.
+ *
+ * the producer (such as an isr, a DMA complete callback or a reader thread) and the consumer may run
+ * on different cores: the indexes are atomic, the elements are published with release/acquire ordering.
+ * only the `spsc_` operations below can be used on it, NOT the macros above.
+ *
+ * @name, @size, @data_type: the same as `static_fifo_declare`, a size which is not a power of 2 (or
+ *                          doesn't fit in `size_type`) is rejected at compile time.
+ * @size_type: the same as `static_fifo_declare`, and `_Atomic size_type` MUST be lock-free on your
+ *             target (usually unsigned char/short/int).
+ *
+ * @example:
+ *   1). declare a char type fifo:    static_spsc_fifo_declare(rx, 256, unsigned short, char);
+ *
+ *   producer side:
+ *   2). add a char:                  if (!spsc_fifo_push(rx, ch)) { overflow... }
+ *   3). add a block:                 size_t n = spsc_fifo_push_n(rx, buf, len);
+ *   4). fill the fifo directly:      size_t n;
+ *                                    char *p = spsc_fifo_write_span(rx, &n);  // n contiguous free elements
+ *                                    n = read(fd, p, n);
+ *                                    spsc_fifo_commit(rx, n);                 // publish them
+ *
+ *   consumer side:
+ *   5). get and remove a char:       char ch;
+ *                                    if (spsc_fifo_pop(rx, &ch)) { ... }
+ *   6). get and remove a block:      size_t n = spsc_fifo_pop_n(rx, buf, sizeof(buf));
+ *   7). use the elements in place:   size_t n;
+ *                                    const char *p = spsc_fifo_read_span(rx, &n);  // n contiguous elements
+ *                                    n = nano_shell_react_buf(p, n);               // the number used
+ *                                    spsc_fifo_consume(rx, n);                     // release them
+ *
+ *   either side:
+ *   8). get size of the fifo:        size_t size = spsc_fifo_size(rx);
+ *       check if it's empty:         spsc_is_fifo_empty(rx)
+ *       get capacity of the fifo:    get_fifo_capacity(rx)
+ *
+ * @note: a span never wraps around the end of the buffer, get a span again for the rest.
+ *
+ */
+#define static_spsc_fifo_declare(name, size, size_type, data_type)                              \
+  static struct {                                                                               \
+    _Atomic size_type head;                                                                     \
+    _Atomic size_type tail;                                                                     \
+    data_type buff[size];                                                                       \
+  } _fifo_##name;                                                                               \
+  _Static_assert((size) >= 2 && ((size) & ((size)-1)) == 0 && (size)-1 <= (size_type)-1,        \
+                 "the size of fifo " #name " must be a power of 2 that fits in its size_type"); \
+  static const size_type _fifo_size_##name = ((size)-1);                                        \
+                                                                                                \
+  static inline size_t _spsc_fifo_size_##name(void)                                             \
+  {                                                                                             \
+    size_type tail = atomic_load_explicit(&_fifo_##name.tail, memory_order_acquire);            \
+    size_type head = atomic_load_explicit(&_fifo_##name.head, memory_order_acquire);            \
+    return (size_type)(head - tail);                                                            \
+  }                                                                                             \
+                                                                                                \
+  static inline data_type *_spsc_fifo_write_span_##name(size_t *n)                              \
+  {                                                                                             \
+    const size_type mask = _fifo_size_##name;                                                   \
+    size_type head = atomic_load_explicit(&_fifo_##name.head, memory_order_relaxed);            \
+    size_type tail = atomic_load_explicit(&_fifo_##name.tail, memory_order_acquire);            \
+    size_t space = mask - (size_type)(head - tail);                                             \
+    size_t contiguous = (size_t)mask + 1 - (head & mask);                                       \
+    *n = (space < contiguous) ? space : contiguous;                                             \
+    return &_fifo_##name.buff[head & mask];                                                     \
+  }                                                                                             \
+                                                                                                \
+  static inline void _spsc_fifo_commit_##name(size_t n)                                         \
+  {                                                                                             \
+    size_type head = atomic_load_explicit(&_fifo_##name.head, memory_order_relaxed);            \
+    atomic_store_explicit(&_fifo_##name.head, (size_type)(head + n), memory_order_release);     \
+  }                                                                                             \
+                                                                                                \
+  static inline data_type *_spsc_fifo_read_span_##name(size_t *n)                               \
+  {                                                                                             \
+    const size_type mask = _fifo_size_##name;                                                   \
+    size_type tail = atomic_load_explicit(&_fifo_##name.tail, memory_order_relaxed);            \
+    size_type head = atomic_load_explicit(&_fifo_##name.head, memory_order_acquire);            \
+    size_t used = (size_type)(head - tail);                                                     \
+    size_t contiguous = (size_t)mask + 1 - (tail & mask);                                       \
+    *n = (used < contiguous) ? used : contiguous;                                               \
+    return &_fifo_##name.buff[tail & mask];                                                     \
+  }                                                                                             \
+                                                                                                \
+  static inline void _spsc_fifo_consume_##name(size_t n)                                        \
+  {                                                                                             \
+    size_type tail = atomic_load_explicit(&_fifo_##name.tail, memory_order_relaxed);            \
+    atomic_store_explicit(&_fifo_##name.tail, (size_type)(tail + n), memory_order_release);     \
+  }                                                                                             \
+                                                                                                \
+  static inline size_t _spsc_fifo_push_n_##name(const data_type *src, size_t n)                 \
+  {                                                                                             \
+    size_t done = 0, len;                                                                       \
+    data_type *span;                                                                            \
+    while (done < n) {                                                                          \
+      span = _spsc_fifo_write_span_##name(&len);                                                \
+      if (len == 0) {                                                                           \
+        break;                                                                                  \
+      }                                                                                         \
+      if (len > n - done) {                                                                     \
+        len = n - done;                                                                         \
+      }                                                                                         \
+      memcpy(span, &src[done], len * sizeof(data_type));                                        \
+      _spsc_fifo_commit_##name(len);                                                            \
+      done += len;                                                                              \
+    }                                                                                           \
+    return done;                                                                                \
+  }                                                                                             \
+                                                                                                \
+  static inline size_t _spsc_fifo_pop_n_##name(data_type *dst, size_t n)                        \
+  {                                                                                             \
+    size_t done = 0, len;                                                                       \
+    const data_type *span;                                                                      \
+    while (done < n) {                                                                          \
+      span = _spsc_fifo_read_span_##name(&len);                                                 \
+      if (len == 0) {                                                                           \
+        break;                                                                                  \
+      }                                                                                         \
+      if (len > n - done) {                                                                     \
+        len = n - done;                                                                         \
+      }                                                                                         \
+      memcpy(&dst[done], span, len * sizeof(data_type));                                        \
+      _spsc_fifo_consume_##name(len);                                                           \
+      done += len;                                                                              \
+    }                                                                                           \
+    return done;                                                                                \
+  }                                                                                             \
+                                                                                                \
+  static inline int _spsc_fifo_push_##name(data_type data)                                      \
+  {                                                                                             \
+    size_t len;                                                                                 \
+    data_type *span = _spsc_fifo_write_span_##name(&len);                                       \
+    if (len == 0) {                                                                             \
+      return 0;                                                                                 \
+    }                                                                                           \
+    *span = data;                                                                               \
+    _spsc_fifo_commit_##name(1);                                                                \
+    return 1;                                                                                   \
+  }                                                                                             \
+                                                                                                \
+  static inline int _spsc_fifo_pop_##name(data_type *data)                                      \
+  {                                                                                             \
+    size_t len;                                                                                 \
+    const data_type *span = _spsc_fifo_read_span_##name(&len);                                  \
+    if (len == 0) {                                                                             \
+      return 0;                                                                                 \
+    }                                                                                           \
+    *data = *span;                                                                              \
+    _spsc_fifo_consume_##name(1);                                                               \
+    return 1;                                                                                   \
+  }                                                                                             \
+                                                                                                \
+  typedef int _spsc_fifo_##name##_end_t /* for the semicolon after the macro */
+
+
+#define spsc_fifo_size(name) _spsc_fifo_size_##name()
+
+#define spsc_is_fifo_empty(name) (_spsc_fifo_size_##name() == 0)
+
+
+/**
+ * @brief: producer side. add a new element to the fifo.
+ *
+ * @return: 1 if it's added, 0 if the fifo is full.
+ */
+#define spsc_fifo_push(name, data) _spsc_fifo_push_##name(data)
+
+
+/**
+ * @brief: producer side. add at most `n` elements of `src` to the fifo.
+ *
+ * @return: the number of elements added.
+ */
+#define spsc_fifo_push_n(name, src, n) _spsc_fifo_push_n_##name((src), (n))
+
+
+/**
+ * @brief: producer side. get the contiguous free space, without adding anything.
+ *         write the elements to it, then add them with `spsc_fifo_commit()`.
+ *
+ * @n: (size_t *) return the number of free elements at the returned pointer, 0 if the fifo is full.
+ */
+#define spsc_fifo_write_span(name, n) _spsc_fifo_write_span_##name(n)
+
+
+/**
+ * @brief: producer side. add `n` elements written to the span, `n` <= the size of the span.
+ */
+#define spsc_fifo_commit(name, n) _spsc_fifo_commit_##name(n)
+
+
+/**
+ * @brief: consumer side. remove the first element of the fifo and return it in `*(pdata)`.
+ *
+ * @return: 1 if there was an element, 0 if the fifo is empty.
+ */
+#define spsc_fifo_pop(name, pdata) _spsc_fifo_pop_##name(pdata)
+
+
+/**
+ * @brief: consumer side. remove at most `n` elements of the fifo to `dst`.
+ *
+ * @return: the number of elements removed.
+ */
+#define spsc_fifo_pop_n(name, dst, n) _spsc_fifo_pop_n_##name((dst), (n))
+
+
+/**
+ * @brief: consumer side. get the contiguous elements at the front of the fifo, without removing them.
+ *         remove them with `spsc_fifo_consume()` when they are used.
+ *
+ * @n: (size_t *) return the number of elements at the returned pointer, 0 if the fifo is empty.
+ */
+#define spsc_fifo_read_span(name, n) _spsc_fifo_read_span_##name(n)
+
+
+/**
+ * @brief: consumer side. remove `n` elements of the span, `n` <= the size of the span.
+ */
+#define spsc_fifo_consume(name, n) _spsc_fifo_consume_##name(n)
+
+#endif /* C11 atomics */
+
+
 #endif